@@ -0,0 +1,121 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__COMMAND_MAILBOX_H_
+#define PB_TELEOP_TWIST_JOY__COMMAND_MAILBOX_H_
+
+// Latest teleop command in POSIX shared memory, for processes that do not link
+// rclcpp. The node is the only writer and guards the command with a seqlock;
+// readers never block it. Plain C99 with GCC/Clang atomic builtins, no library
+// beyond libc:
+//
+//   int fd = shm_open("/pb_teleop_command", O_RDONLY, 0);
+//   const pb_teleop_mailbox_t * mailbox =
+//     mmap(NULL, sizeof(pb_teleop_mailbox_t), PROT_READ, MAP_SHARED, fd, 0);
+//   pb_teleop_command_t command;
+//   if (pb_teleop_mailbox_valid(mailbox) && pb_teleop_mailbox_read(mailbox, &command, 16) == 0) {
+//     ...
+//   }
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PB_TELEOP_MAILBOX_MAGIC 0x43544250u  // "PBTC"
+#define PB_TELEOP_MAILBOX_VERSION 1u
+#define PB_TELEOP_MAILBOX_MAX_JOINTS 16
+
+// Values of pb_teleop_command_t::profile.
+#define PB_TELEOP_PROFILE_DISABLED 0
+#define PB_TELEOP_PROFILE_NORMAL 1
+#define PB_TELEOP_PROFILE_TURBO 2
+
+// Made of 8 byte words only, so it is copied word by word.
+typedef struct pb_teleop_command
+{
+  // Node clock when the command was produced, in nanoseconds.
+  int64_t stamp_ns;
+  // Increments with every command, a reader sees a new command when it changes.
+  uint64_t sequence;
+  // Chassis twist as published on cmd_vel.
+  double linear[3];
+  double angular[3];
+  double shoot;
+  int32_t profile;
+  uint32_t num_joints;
+  // Joint setpoints in the order of cmd_gimbal_joint.
+  double joints[PB_TELEOP_MAILBOX_MAX_JOINTS];
+} pb_teleop_command_t;
+
+typedef struct pb_teleop_mailbox
+{
+  uint32_t magic;
+  uint32_t version;
+  // Odd while the node writes the command.
+  uint64_t seqlock;
+  pb_teleop_command_t command;
+} pb_teleop_mailbox_t;
+
+static inline int pb_teleop_mailbox_valid(const pb_teleop_mailbox_t * mailbox)
+{
+  return __atomic_load_n(&mailbox->magic, __ATOMIC_ACQUIRE) == PB_TELEOP_MAILBOX_MAGIC &&
+         mailbox->version == PB_TELEOP_MAILBOX_VERSION;
+}
+
+// Copies a consistent command. Gives up after max_attempts collisions with the
+// writer and returns -1, 0 on success.
+static inline int pb_teleop_mailbox_read(
+  const pb_teleop_mailbox_t * mailbox, pb_teleop_command_t * command, int max_attempts)
+{
+  const uint64_t * source = (const uint64_t *)&mailbox->command;
+  uint64_t * destination = (uint64_t *)command;
+  for (int attempt = 0; attempt < max_attempts; ++attempt) {
+    uint64_t begin = __atomic_load_n(&mailbox->seqlock, __ATOMIC_ACQUIRE);
+    if (begin & 1u) {
+      continue;
+    }
+    for (size_t i = 0; i < sizeof(pb_teleop_command_t) / sizeof(uint64_t); ++i) {
+      destination[i] = __atomic_load_n(&source[i], __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&mailbox->seqlock, __ATOMIC_RELAXED) == begin) {
+      return 0;
+    }
+  }
+  return -1;
+}
+
+// Writer side, used by the node.
+static inline void pb_teleop_mailbox_write(
+  pb_teleop_mailbox_t * mailbox, const pb_teleop_command_t * command)
+{
+  const uint64_t * source = (const uint64_t *)command;
+  uint64_t * destination = (uint64_t *)&mailbox->command;
+  uint64_t seqlock = __atomic_load_n(&mailbox->seqlock, __ATOMIC_RELAXED);
+  __atomic_store_n(&mailbox->seqlock, seqlock + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  for (size_t i = 0; i < sizeof(pb_teleop_command_t) / sizeof(uint64_t); ++i) {
+    __atomic_store_n(&destination[i], source[i], __ATOMIC_RELAXED);
+  }
+  __atomic_store_n(&mailbox->seqlock, seqlock + 2, __ATOMIC_RELEASE);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // PB_TELEOP_TWIST_JOY__COMMAND_MAILBOX_H_
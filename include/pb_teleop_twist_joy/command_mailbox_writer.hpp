@@ -0,0 +1,53 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__COMMAND_MAILBOX_WRITER_HPP_
+#define PB_TELEOP_TWIST_JOY__COMMAND_MAILBOX_WRITER_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pb_teleop_twist_joy/command_mailbox.h"
+#include "pb_teleop_twist_joy/teleop_mapper.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+// Owns the node's mapping of the command mailbox. The segment outlives the
+// node, so readers keep their mapping across node restarts.
+class CommandMailboxWriter
+{
+public:
+  CommandMailboxWriter() = default;
+  ~CommandMailboxWriter();
+  CommandMailboxWriter(const CommandMailboxWriter &) = delete;
+  CommandMailboxWriter & operator=(const CommandMailboxWriter &) = delete;
+
+  // Creates or reuses the shared memory object `name` (e.g. "/pb_teleop_command").
+  // On failure returns false and describes why in `error`.
+  bool open(const std::string & name, std::string * error);
+
+  bool isOpen() const { return mailbox_ != nullptr; }
+
+  void write(const TeleopCommand & command, const std::vector<double> & joints, int64_t stamp_ns);
+
+private:
+  pb_teleop_mailbox_t * mailbox_ = nullptr;
+  pb_teleop_command_t command_ = {};
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__COMMAND_MAILBOX_WRITER_HPP_
@@ -0,0 +1,64 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__COSTMAP_CACHE_HPP_
+#define PB_TELEOP_TWIST_JOY__COSTMAP_CACHE_HPP_
+
+#include <cstdint>
+#include <vector>
+
+namespace pb_teleop_twist_joy
+{
+
+// Copy of an occupancy grid costmap (0 free to 100 lethal, -1 unknown), kept
+// current from partial updates, used to move goals out of obstacles before
+// they reach the planner.
+class CostmapCache
+{
+public:
+  void setMap(
+    double resolution, double origin_x, double origin_y, uint32_t width, uint32_t height,
+    const std::vector<int8_t> & data);
+
+  // Copies a window of cells. Returns false when it does not fit the map, e.g.
+  // an update for a map that has not arrived yet.
+  bool update(
+    uint32_t x, uint32_t y, uint32_t width, uint32_t height, const std::vector<int8_t> & data);
+
+  bool empty() const { return cells_.empty(); }
+
+  // Moves (x, y) to the center of the nearest cell with a cost below
+  // `occupied_threshold`, searching at most `max_distance` away. Unknown cells
+  // are free only with `allow_unknown`. Points off the map are left alone.
+  // Returns false when no free cell is in reach.
+  bool snapToFree(
+    double * x, double * y, int occupied_threshold, double max_distance, bool allow_unknown) const;
+
+private:
+  static bool isFree(int8_t cost, int occupied_threshold, bool allow_unknown)
+  {
+    return cost < 0 ? allow_unknown : cost < occupied_threshold;
+  }
+
+  double resolution_ = 0.0;
+  double origin_x_ = 0.0;
+  double origin_y_ = 0.0;
+  int64_t width_ = 0;
+  int64_t height_ = 0;
+  std::vector<int8_t> cells_;
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__COSTMAP_CACHE_HPP_
@@ -0,0 +1,58 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__DURATION_HISTOGRAM_HPP_
+#define PB_TELEOP_TWIST_JOY__DURATION_HISTOGRAM_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pb_teleop_twist_joy
+{
+
+// Fixed-size log-linear histogram of durations in nanoseconds with eight
+// buckets per power of two, i.e. percentiles are accurate to about 12 %.
+// Recording is branch-light and never allocates.
+class DurationHistogram
+{
+public:
+  DurationHistogram();
+
+  void record(int64_t duration_ns);
+  void reset();
+
+  uint64_t count() const { return count_; }
+  int64_t min() const { return count_ == 0 ? 0 : min_; }
+  int64_t max() const { return max_; }
+  double mean() const;
+  // Upper bound of the bucket holding the q-quantile, 0 <= q <= 1.
+  int64_t percentile(double q) const;
+
+private:
+  static constexpr size_t SUB_BUCKETS = 8;
+  static constexpr size_t NUM_BUCKETS = 64 * SUB_BUCKETS;
+
+  static size_t bucketOf(uint64_t value);
+  static uint64_t bucketUpperBound(size_t bucket);
+
+  uint64_t buckets_[NUM_BUCKETS];
+  uint64_t count_;
+  double sum_;
+  int64_t min_;
+  int64_t max_;
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__DURATION_HISTOGRAM_HPP_
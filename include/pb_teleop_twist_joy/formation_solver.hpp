@@ -0,0 +1,98 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__FORMATION_SOLVER_HPP_
+#define PB_TELEOP_TWIST_JOY__FORMATION_SOLVER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pb_teleop_twist_joy
+{
+
+// Place of one robot in the formation, in the frame of the formation center.
+struct FormationSlot
+{
+  double x = 0.0;
+  double y = 0.0;
+  double yaw = 0.0;
+};
+
+// Drives a group of robots as one rigid body. The sticks move a virtual
+// formation center, and every robot gets the velocity of its slot on that body
+// plus a proportional correction towards the slot, expressed in its own base
+// frame. All robot state is kept as parallel arrays so one solve() is a few
+// tight loops over the group.
+class FormationSolver
+{
+public:
+  void configure(
+    const std::vector<FormationSlot> & slots, double position_gain, double yaw_gain,
+    double max_linear_correction, double max_angular_correction);
+
+  size_t size() const { return offset_x_.size(); }
+
+  // Latest pose of one robot, all robots in the same fixed frame.
+  void setPose(size_t robot, double x, double y, double yaw, int64_t stamp_ns);
+
+  // Forgets the formation center, it is re-anchored on the robots' poses by
+  // the next solve().
+  void reset() { anchored_ = false; }
+
+  // Group twist in the formation frame. Robots whose pose is older than
+  // pose_timeout_ns get a zero twist and are left out of the anchoring.
+  void solve(
+    double linear_x, double linear_y, double angular_z, double dt, int64_t now_ns,
+    int64_t pose_timeout_ns);
+
+  // Per robot body frame twists of the last solve().
+  const std::vector<double> & linearX() const { return cmd_x_; }
+  const std::vector<double> & linearY() const { return cmd_y_; }
+  const std::vector<double> & angularZ() const { return cmd_yaw_; }
+
+private:
+  bool anchor(const uint8_t * fresh);
+
+  double position_gain_ = 0.0;
+  double yaw_gain_ = 0.0;
+  double max_linear_correction_ = 0.0;
+  double max_angular_correction_ = 0.0;
+
+  std::vector<double> offset_x_;
+  std::vector<double> offset_y_;
+  std::vector<double> offset_yaw_;
+
+  // Poses with the heading pre-split into cosine and sine on arrival.
+  std::vector<double> pose_x_;
+  std::vector<double> pose_y_;
+  std::vector<double> pose_yaw_;
+  std::vector<double> pose_cos_;
+  std::vector<double> pose_sin_;
+  std::vector<int64_t> pose_stamp_ns_;
+  std::vector<uint8_t> fresh_;
+
+  bool anchored_ = false;
+  double center_x_ = 0.0;
+  double center_y_ = 0.0;
+  double center_yaw_ = 0.0;
+
+  std::vector<double> cmd_x_;
+  std::vector<double> cmd_y_;
+  std::vector<double> cmd_yaw_;
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__FORMATION_SOLVER_HPP_
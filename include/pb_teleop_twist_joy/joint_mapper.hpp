@@ -0,0 +1,94 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__JOINT_MAPPER_HPP_
+#define PB_TELEOP_TWIST_JOY__JOINT_MAPPER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "pb_teleop_twist_joy/joy_snapshot.hpp"
+#include "pb_teleop_twist_joy/mapping_core.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+enum class JointMode
+{
+  // Axis commands the joint velocity, the setpoint is integrated.
+  RATE,
+  // Axis commands the joint setpoint directly.
+  POSITION,
+};
+
+struct JointBinding
+{
+  std::string name;
+  int64_t axis = -1;
+  double scale = 0.0;
+  double scale_turbo = 0.0;
+  JointMode mode = JointMode::RATE;
+  double min = -std::numeric_limits<double>::infinity();
+  double max = std::numeric_limits<double>::infinity();
+  size_t output_index = 0;
+};
+
+// Maps joystick axes onto an arbitrary number of joint setpoints. Bindings are
+// stored as parallel arrays sized once in configure(), so update() touches only
+// contiguous memory and never allocates.
+class JointMapper
+{
+public:
+  // Returns false when the output indices are not a permutation of
+  // 0..bindings.size()-1, in which case list order is used instead.
+  bool configure(const std::vector<JointBinding> & bindings);
+
+  void update(const JoySnapshot & joy, bool turbo, double dt);
+
+  // Sets the setpoints, ordered by output index, e.g. to resume after a
+  // restart. They are limited as in update(). Ignored on a size mismatch.
+  void restore(const std::vector<double> & positions);
+
+  // Setpoints reached from `start` while `joy` is held, after 1 to num_steps
+  // updates of `step` seconds, as num_steps rows ordered by output index. The
+  // velocities are those of the step ending at each point, so they drop to
+  // zero once a limit holds the joint. Reads only the bindings, not the state.
+  void predict(
+    const std::vector<double> & start, const JoySnapshot & joy, bool turbo, double step,
+    size_t num_steps, double * positions, double * velocities) const;
+
+  size_t size() const { return axis_.size(); }
+  // Joint names and setpoints ordered by output index.
+  const std::vector<std::string> & names() const { return names_; }
+  const std::vector<double> & positions() const { return output_; }
+
+private:
+  std::vector<int64_t> axis_;
+  std::vector<double> scale_;
+  std::vector<double> scale_turbo_;
+  std::vector<uint8_t> integrate_;
+  std::vector<double> min_;
+  std::vector<double> max_;
+  std::vector<size_t> output_index_;
+
+  std::vector<std::string> names_;
+  std::vector<double> output_;
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__JOINT_MAPPER_HPP_
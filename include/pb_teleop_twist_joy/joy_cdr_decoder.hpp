@@ -0,0 +1,50 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__JOY_CDR_DECODER_HPP_
+#define PB_TELEOP_TWIST_JOY__JOY_CDR_DECODER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "pb_teleop_twist_joy/joy_snapshot.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+// Reads the stamp and the bound axes and buttons of a CDR serialized
+// sensor_msgs/msg/Joy straight from the buffer, skipping everything else.
+class JoyCdrDecoder
+{
+public:
+  JoyCdrDecoder();
+
+  // Indices outside the snapshot capacity or negative are ignored.
+  void bind(const std::vector<int64_t> & axes, const std::vector<int64_t> & buttons);
+
+  // Only the bound entries of `snapshot` are written, so a snapshot reused
+  // across calls keeps every other entry at its initial zero.
+  bool decode(const uint8_t * data, size_t size, JoySnapshot * snapshot) const;
+
+private:
+  uint8_t bound_axes_[JOY_MAX_AXES];
+  size_t num_bound_axes_;
+  uint8_t bound_buttons_[JOY_MAX_BUTTONS];
+  size_t num_bound_buttons_;
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__JOY_CDR_DECODER_HPP_
@@ -0,0 +1,59 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__JOY_SNAPSHOT_HPP_
+#define PB_TELEOP_TWIST_JOY__JOY_SNAPSHOT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace pb_teleop_twist_joy
+{
+
+constexpr size_t JOY_MAX_AXES = 32;
+constexpr size_t JOY_MAX_BUTTONS = 32;
+
+// Fixed-size copy of the joystick state the mapping works on. `num_axes` and
+// `num_buttons` are the sizes reported by the input, indices past the capacity
+// read as zero.
+struct JoySnapshot
+{
+  int64_t stamp_ns = 0;
+  uint32_t num_axes = 0;
+  uint32_t num_buttons = 0;
+  float axes[JOY_MAX_AXES] = {};
+  int32_t buttons[JOY_MAX_BUTTONS] = {};
+
+  double axis(int64_t index) const
+  {
+    if (index < 0 || index >= static_cast<int64_t>(num_axes) || index >= int64_t{JOY_MAX_AXES}) {
+      return 0.0;
+    }
+    return axes[index];
+  }
+
+  bool button(int64_t index) const
+  {
+    if (
+      index < 0 || index >= static_cast<int64_t>(num_buttons) ||
+      index >= int64_t{JOY_MAX_BUTTONS}) {
+      return false;
+    }
+    return buttons[index] != 0;
+  }
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__JOY_SNAPSHOT_HPP_
@@ -0,0 +1,108 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__MAPPING_CONFIG_HPP_
+#define PB_TELEOP_TWIST_JOY__MAPPING_CONFIG_HPP_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "pb_teleop_twist_joy/joint_mapper.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+// Where the mapping parameters come from: the node's ROS parameters, or a
+// plain dictionary in the Python bindings. Each getter returns the value of
+// `name` or `default_value` when it is not set.
+class ParameterSource
+{
+public:
+  virtual ~ParameterSource() = default;
+  virtual bool getBool(const std::string & name, bool default_value) = 0;
+  virtual int64_t getInt(const std::string & name, int64_t default_value) = 0;
+  virtual double getDouble(const std::string & name, double default_value) = 0;
+  virtual std::string getString(const std::string & name, const std::string & default_value) = 0;
+  virtual std::vector<std::string> getStringArray(
+    const std::string & name, const std::vector<std::string> & default_value) = 0;
+};
+
+// Reads `prefix` + name from `source`, defaulting to the unprefixed name, so a
+// prefixed config only has to list what differs from the top level one.
+class OverlayParameterSource : public ParameterSource
+{
+public:
+  OverlayParameterSource(ParameterSource * source, const std::string & prefix)
+  : source_(source), prefix_(prefix)
+  {
+  }
+
+  bool getBool(const std::string & name, bool default_value) override
+  {
+    return source_->getBool(name, source_->getBool(baseName(name), default_value));
+  }
+  int64_t getInt(const std::string & name, int64_t default_value) override
+  {
+    return source_->getInt(name, source_->getInt(baseName(name), default_value));
+  }
+  double getDouble(const std::string & name, double default_value) override
+  {
+    return source_->getDouble(name, source_->getDouble(baseName(name), default_value));
+  }
+  std::string getString(const std::string & name, const std::string & default_value) override
+  {
+    return source_->getString(name, source_->getString(baseName(name), default_value));
+  }
+  std::vector<std::string> getStringArray(
+    const std::string & name, const std::vector<std::string> & default_value) override
+  {
+    return source_->getStringArray(name, source_->getStringArray(baseName(name), default_value));
+  }
+
+private:
+  std::string baseName(const std::string & name) const
+  {
+    return name.compare(0, prefix_.size(), prefix_) == 0 ? name.substr(prefix_.size()) : name;
+  }
+
+  ParameterSource * source_;
+  std::string prefix_;
+};
+
+struct MappingConfig
+{
+  bool require_enable_button = true;
+  int64_t enable_button = 5;
+  int64_t enable_turbo_button = -1;
+  bool inverted_reverse = false;
+  double max_integration_dt = 0.1;
+
+  std::map<std::string, int64_t> axis_chassis;
+  std::map<std::string, std::map<std::string, double>> scale_chassis;
+  std::map<std::string, int64_t> axis_gimbal;
+  std::map<std::string, std::map<std::string, double>> scale_gimbal;
+
+  std::vector<JointBinding> joints;
+  // Problems found while loading, for the caller to report.
+  std::vector<std::string> warnings;
+};
+
+// Reads every mapping parameter below `prefix` ("" for the top level).
+MappingConfig loadMappingConfig(ParameterSource * parameters, const std::string & prefix = "");
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__MAPPING_CONFIG_HPP_
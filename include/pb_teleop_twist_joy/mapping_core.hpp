@@ -0,0 +1,260 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__MAPPING_CORE_HPP_
+#define PB_TELEOP_TWIST_JOY__MAPPING_CORE_HPP_
+
+// The arithmetic of the joystick mapping, shared by the node and the robot's
+// microcontroller firmware. Header-only, C++14, no allocation, no exceptions and
+// no dependency beyond <cstddef>, <cstdint> and <limits>; every function is
+// constexpr. Scalar is double on the node and float or Fixed on the MCU.
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace pb_teleop_twist_joy
+{
+
+enum class SpeedProfile : int8_t
+{
+  DISABLED = 0,
+  NORMAL = 1,
+  TURBO = 2,
+};
+
+// Chassis axes in the order of the chassis command arrays.
+enum ChassisAxis
+{
+  LINEAR_X,
+  LINEAR_Y,
+  LINEAR_Z,
+  ANGULAR_X,
+  ANGULAR_Y,
+  ANGULAR_Z,
+  NUM_CHASSIS_AXES,
+};
+
+// Signed fixed point number with FRAC_BITS fractional bits in 32 bits, for
+// targets without an FPU. Arithmetic saturates instead of wrapping.
+template <int FRAC_BITS>
+class Fixed
+{
+  static_assert(FRAC_BITS > 0 && FRAC_BITS < 31, "FRAC_BITS must be in 1..30.");
+
+public:
+  constexpr Fixed() : raw_(0) {}
+
+  static constexpr Fixed fromRaw(int64_t raw) { return Fixed(saturate(raw)); }
+
+  static constexpr Fixed fromDouble(double value)
+  {
+    return value != value ? Fixed()
+           : value >= static_cast<double>(rawMax()) / one() ? Fixed(rawMax())
+           : value <= static_cast<double>(rawMin()) / one()
+             ? Fixed(rawMin())
+             : Fixed(static_cast<int32_t>(value * one() + (value < 0.0 ? -0.5 : 0.5)));
+  }
+
+  constexpr int32_t raw() const { return raw_; }
+  constexpr double toDouble() const { return static_cast<double>(raw_) / one(); }
+
+  friend constexpr Fixed operator+(Fixed a, Fixed b) { return fromRaw(int64_t{a.raw_} + b.raw_); }
+  friend constexpr Fixed operator-(Fixed a, Fixed b) { return fromRaw(int64_t{a.raw_} - b.raw_); }
+  friend constexpr Fixed operator-(Fixed a) { return fromRaw(-int64_t{a.raw_}); }
+  friend constexpr Fixed operator*(Fixed a, Fixed b)
+  {
+    // Rounds to nearest. Right shifts of negative values are arithmetic on every
+    // compiler we target.
+    return fromRaw((int64_t{a.raw_} * b.raw_ + (int64_t{1} << (FRAC_BITS - 1))) >> FRAC_BITS);
+  }
+  friend constexpr bool operator<(Fixed a, Fixed b) { return a.raw_ < b.raw_; }
+  friend constexpr bool operator==(Fixed a, Fixed b) { return a.raw_ == b.raw_; }
+  friend constexpr bool operator!=(Fixed a, Fixed b) { return a.raw_ != b.raw_; }
+
+private:
+  static constexpr int64_t one() { return int64_t{1} << FRAC_BITS; }
+  static constexpr int32_t rawMax() { return std::numeric_limits<int32_t>::max(); }
+  static constexpr int32_t rawMin() { return std::numeric_limits<int32_t>::min(); }
+
+  constexpr explicit Fixed(int32_t raw) : raw_(raw) {}
+
+  static constexpr int32_t saturate(int64_t raw)
+  {
+    return raw > rawMax() ? rawMax() : raw < rawMin() ? rawMin() : static_cast<int32_t>(raw);
+  }
+
+  int32_t raw_;
+};
+
+template <typename Scalar>
+struct ScalarTraits
+{
+  static constexpr Scalar fromDouble(double value) { return static_cast<Scalar>(value); }
+};
+
+template <int FRAC_BITS>
+struct ScalarTraits<Fixed<FRAC_BITS>>
+{
+  static constexpr Fixed<FRAC_BITS> fromDouble(double value)
+  {
+    return Fixed<FRAC_BITS>::fromDouble(value);
+  }
+};
+
+// Converts configuration values, e.g. toScalar<Fixed<16>>(0.5).
+template <typename Scalar>
+constexpr Scalar toScalar(double value)
+{
+  return ScalarTraits<Scalar>::fromDouble(value);
+}
+
+constexpr SpeedProfile selectSpeedProfile(
+  bool turbo_pressed, bool enable_pressed, bool require_enable_button)
+{
+  return turbo_pressed                                ? SpeedProfile::TURBO
+         : (!require_enable_button || enable_pressed) ? SpeedProfile::NORMAL
+                                                      : SpeedProfile::DISABLED;
+}
+
+// Same as std::min(std::max(value, min), max), including when min > max.
+template <typename Scalar>
+constexpr Scalar limitSetpoint(Scalar value, Scalar min, Scalar max)
+{
+  return max < (value < min ? min : value) ? max : (value < min ? min : value);
+}
+
+// Where a joint starts: zero, or the nearest limit when zero is not reachable.
+template <typename Scalar>
+constexpr Scalar initialJointSetpoint(Scalar min, Scalar max)
+{
+  return limitSetpoint(Scalar(), min, max);
+}
+
+// One joint update. A rate joint integrates the command over dt, a position
+// joint takes the command as its setpoint.
+template <typename Scalar>
+constexpr Scalar stepJoint(
+  Scalar setpoint, Scalar command, Scalar dt, bool integrate, Scalar min, Scalar max)
+{
+  return limitSetpoint(integrate ? setpoint + command * dt : command, min, max);
+}
+
+// With inverted_reverse the yaw flips while driving backwards, so the stick
+// steers like a car.
+template <typename Scalar>
+constexpr Scalar reverseYaw(Scalar linear_x, Scalar angular_z, bool inverted_reverse)
+{
+  return (inverted_reverse && linear_x < Scalar()) ? -angular_z : angular_z;
+}
+
+// Binding table for targets that cannot load ROS parameters; every index of -1
+// or past the input is unbound.
+template <typename Scalar>
+struct CoreJointBinding
+{
+  int16_t axis = -1;
+  Scalar scale = Scalar();
+  Scalar scale_turbo = Scalar();
+  bool integrate = true;
+  Scalar min = toScalar<Scalar>(-std::numeric_limits<double>::infinity());
+  Scalar max = toScalar<Scalar>(std::numeric_limits<double>::infinity());
+  uint8_t output_index = 0;
+};
+
+template <typename Scalar, size_t MAX_JOINTS>
+struct CoreMappingConfig
+{
+  bool require_enable_button = true;
+  int16_t enable_button = -1;
+  int16_t enable_turbo_button = -1;
+  bool inverted_reverse = false;
+  int16_t chassis_axis[NUM_CHASSIS_AXES] = {-1, -1, -1, -1, -1, -1};
+  // [profile][axis], profile 0 is normal and 1 turbo.
+  Scalar chassis_scale[2][NUM_CHASSIS_AXES] = {};
+  int16_t shoot_axis = -1;
+  Scalar shoot_scale = Scalar();
+  size_t num_joints = 0;
+  CoreJointBinding<Scalar> joints[MAX_JOINTS] = {};
+};
+
+template <typename Scalar, size_t MAX_JOINTS>
+struct CoreCommand
+{
+  SpeedProfile profile = SpeedProfile::DISABLED;
+  Scalar chassis[NUM_CHASSIS_AXES] = {};
+  Scalar shoot = Scalar();
+  // By output index. Also the integration state, keep it between calls.
+  Scalar joints[MAX_JOINTS] = {};
+};
+
+template <typename Scalar>
+constexpr Scalar coreAxis(const Scalar * axes, size_t num_axes, int64_t index)
+{
+  return (index < 0 || static_cast<size_t>(index) >= num_axes) ? Scalar() : axes[index];
+}
+
+constexpr bool coreButton(const int32_t * buttons, size_t num_buttons, int64_t index)
+{
+  return index >= 0 && static_cast<size_t>(index) < num_buttons && buttons[index] != 0;
+}
+
+template <typename Scalar, size_t MAX_JOINTS>
+constexpr void resetCoreCommand(
+  const CoreMappingConfig<Scalar, MAX_JOINTS> & config, CoreCommand<Scalar, MAX_JOINTS> * command)
+{
+  *command = CoreCommand<Scalar, MAX_JOINTS>();
+  for (size_t i = 0; i < config.num_joints && i < MAX_JOINTS; ++i) {
+    const CoreJointBinding<Scalar> & joint = config.joints[i];
+    command->joints[joint.output_index] = initialJointSetpoint(joint.min, joint.max);
+  }
+}
+
+// The whole mapping for one input sample, as TeleopMapper::map() does it.
+// Output indices must be a permutation of 0..num_joints-1.
+template <typename Scalar, size_t MAX_JOINTS>
+constexpr void mapCoreCommand(
+  const CoreMappingConfig<Scalar, MAX_JOINTS> & config, const Scalar * axes, size_t num_axes,
+  const int32_t * buttons, size_t num_buttons, Scalar dt, CoreCommand<Scalar, MAX_JOINTS> * command)
+{
+  command->profile = selectSpeedProfile(
+    coreButton(buttons, num_buttons, config.enable_turbo_button),
+    coreButton(buttons, num_buttons, config.enable_button), config.require_enable_button);
+
+  if (command->profile == SpeedProfile::DISABLED) {
+    for (size_t i = 0; i < NUM_CHASSIS_AXES; ++i) {
+      command->chassis[i] = Scalar();
+    }
+  } else {
+    const bool turbo = command->profile == SpeedProfile::TURBO;
+    for (size_t i = 0; i < NUM_CHASSIS_AXES; ++i) {
+      command->chassis[i] =
+        coreAxis(axes, num_axes, config.chassis_axis[i]) * config.chassis_scale[turbo ? 1 : 0][i];
+    }
+    command->chassis[ANGULAR_Z] = reverseYaw(
+      command->chassis[LINEAR_X], command->chassis[ANGULAR_Z], config.inverted_reverse);
+    for (size_t i = 0; i < config.num_joints && i < MAX_JOINTS; ++i) {
+      const CoreJointBinding<Scalar> & joint = config.joints[i];
+      Scalar & setpoint = command->joints[joint.output_index];
+      setpoint = stepJoint(
+        setpoint, coreAxis(axes, num_axes, joint.axis) * (turbo ? joint.scale_turbo : joint.scale),
+        dt, joint.integrate, joint.min, joint.max);
+    }
+  }
+  command->shoot = coreAxis(axes, num_axes, config.shoot_axis) * config.shoot_scale;
+}
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__MAPPING_CORE_HPP_
@@ -15,21 +15,50 @@
 #ifndef PB_TELEOP_TWIST_JOY__PB_TELEOP_TWIST_JOY_HPP_
 #define PB_TELEOP_TWIST_JOY__PB_TELEOP_TWIST_JOY_HPP_
 
+#include <atomic>
+#include <condition_variable>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
+#include "example_interfaces/msg/float64.hpp"
 #include "example_interfaces/msg/u_int8.hpp"
+#include "geometry_msgs/msg/pose_stamped.hpp"
 #include "geometry_msgs/msg/twist.hpp"
 #include "geometry_msgs/msg/twist_stamped.hpp"
+#include "map_msgs/msg/occupancy_grid_update.hpp"
+#include "nav_msgs/msg/occupancy_grid.hpp"
 #include "nav2_msgs/action/navigate_to_pose.hpp"
+#include "pb_teleop_twist_joy/command_mailbox_writer.hpp"
+#include "pb_teleop_twist_joy/costmap_cache.hpp"
+#include "pb_teleop_twist_joy/duration_histogram.hpp"
+#include "pb_teleop_twist_joy/formation_solver.hpp"
+#include "pb_teleop_twist_joy/joy_cdr_decoder.hpp"
+#include "pb_teleop_twist_joy/joy_snapshot.hpp"
+#include "pb_teleop_twist_joy/mapping_config.hpp"
+#include "pb_teleop_twist_joy/perf_counters.hpp"
+#include "pb_teleop_twist_joy/phase_lock.hpp"
+#include "pb_teleop_twist_joy/power_governor.hpp"
+#include "pb_teleop_twist_joy/publisher_health.hpp"
+#include "pb_teleop_twist_joy/rc_frame_decoder.hpp"
+#include "pb_teleop_twist_joy/rc_serial_port.hpp"
+#include "pb_teleop_twist_joy/runtime_state_file.hpp"
+#include "pb_teleop_twist_joy/spsc_ring.hpp"
+#include "pb_teleop_twist_joy/teleop_mapper.hpp"
+#include "pb_teleop_twist_joy/throttled_logger.hpp"
 #include "rclcpp/rclcpp.hpp"
 #include "rclcpp_action/rclcpp_action.hpp"
 #include "sensor_msgs/msg/joint_state.hpp"
 #include "sensor_msgs/msg/joy.hpp"
+#include "tf2/utils.h"
 #include "tf2_geometry_msgs/tf2_geometry_msgs.hpp"
 #include "tf2_ros/buffer.h"
 #include "tf2_ros/transform_listener.h"
+#include "trajectory_msgs/msg/joint_trajectory.hpp"
 
 namespace pb_teleop_twist_joy
 {
@@ -38,27 +67,77 @@ class TeleopTwistJoyNode : public rclcpp::Node
 {
 public:
   explicit TeleopTwistJoyNode(const rclcpp::NodeOptions & options);
+  ~TeleopTwistJoyNode() override;
 
 private:
   void joyCallback(const sensor_msgs::msg::Joy::SharedPtr joy_msg);
-  void sendCmdVelMsg(const sensor_msgs::msg::Joy::SharedPtr joy_msg, const std::string & which_map);
-  void fillCmdVelMsg(
-    const sensor_msgs::msg::Joy::SharedPtr joy_msg, const std::string & which_map,
-    geometry_msgs::msg::Twist * cmd_vel_msg);
+  void serializedJoyCallback(std::shared_ptr<rclcpp::SerializedMessage> serialized_msg);
+  void onJoyInput(const JoySnapshot & joy);
+  void setupBridge(const rclcpp::NodeOptions & options, size_t domain_id);
+  void setupRcInput(RcProtocol protocol);
+  void rcInputLoop();
+  void processJoy(const JoySnapshot & joy);
+  // Returns the integration step, which the output stage needs along with the
+  // command: in pipeline mode it runs on another thread than the mapping.
+  double mapJoy(const JoySnapshot & joy, TeleopCommand * command);
+  void publishCommand(
+    const TeleopCommand & command, const std::vector<double> & joints, const JoySnapshot & joy,
+    double dt, int64_t start_ns);
+  void sendTrajectory(
+    const TeleopCommand & command, const std::vector<double> & joints, const JoySnapshot & joy);
+  void setupPipeline();
+  void pipelineDecodeLoop();
+  void pipelineMappingLoop();
+  void pipelineOutputLoop();
+  void controllerTickCallback(const sensor_msgs::msg::JointState::SharedPtr tick_msg);
+  void phaseLockLoop();
+  bool waitForPhaseLock(const rclcpp::Clock::SharedPtr & clock, int64_t target_ns);
+  void sendCmdVelMsg(
+    const TeleopCommand & command, const std::vector<double> & joints, double dt);
+  void fillCmdVelMsg(const TeleopCommand & command, geometry_msgs::msg::Twist * cmd_vel_msg);
   void fillJointStateMsg(
-    const sensor_msgs::msg::Joy::SharedPtr joy_msg, const std::string & which_map,
-    sensor_msgs::msg::JointState * joint_state_msg);
-  void fillShootMsg(
-    const sensor_msgs::msg::Joy::SharedPtr joy_msg, const std::string & which_map,
-    example_interfaces::msg::UInt8 * shoot_msg);
-  void sendGoalPoseAction(
-    const sensor_msgs::msg::Joy::SharedPtr joy_msg, const std::string & which_map);
+    const std::vector<double> & joints, sensor_msgs::msg::JointState * joint_state_msg);
+  void fillShootMsg(const TeleopCommand & command, example_interfaces::msg::UInt8 * shoot_msg);
+  void sendGoalPoseAction(const TeleopCommand & command);
+  void costmapCallback(const nav_msgs::msg::OccupancyGrid::SharedPtr costmap_msg);
+  void costmapUpdateCallback(const map_msgs::msg::OccupancyGridUpdate::SharedPtr update_msg);
   void sendZeroCommand();
-  double getVal(
-    const sensor_msgs::msg::Joy::SharedPtr joy_msg, const std::map<std::string, int64_t> & axis_map,
-    const std::map<std::string, double> & scale_map, const std::string & fieldname);
+  void setupFormation();
+  void formationPoseCallback(
+    size_t robot, const geometry_msgs::msg::PoseStamped::SharedPtr pose_msg);
+  void sendFormationCmdVel(const TeleopCommand & command, double dt);
+  void stopFormation();
+  void setupPowerGovernor();
+  void governChassisPower(TeleopCommand * command);
+  void pollPublisherHealth();
+  bool outputWanted(const PublisherHealth & health) const;
+  void publishStatistics();
+  void setupShadow(ParameterSource * parameters);
+  void bindJoyDecoder();
+  void runShadow(const JoySnapshot & joy, double dt);
+
+  // Node in a second context on another ROS domain, so commands reach the robot
+  // or joy comes from the operator station without a domain_bridge process.
+  // Declared first, its publishers and subscriptions must go before it.
+  rclcpp::Context::SharedPtr bridge_context_;
+  rclcpp::Node::SharedPtr bridge_node_;
+  std::shared_ptr<rclcpp::executors::SingleThreadedExecutor> bridge_executor_;
+  std::thread bridge_thread_;
 
   rclcpp::Subscription<sensor_msgs::msg::Joy>::SharedPtr joy_sub_;
+  rclcpp::GenericSubscription::SharedPtr joy_serialized_sub_;
+  JoyCdrDecoder joy_decoder_;
+  JoySnapshot serialized_joy_;
+
+  // RC receiver read straight from a serial port instead of the joy topic.
+  RcProtocol rc_protocol_;
+  std::string rc_device_;
+  int64_t rc_timeout_ns_;
+  std::unique_ptr<RcFrameDecoder> rc_decoder_;
+  RcSerialPort rc_port_;
+  std::thread rc_thread_;
+  std::atomic<bool> rc_stop_;
+
   rclcpp::Publisher<geometry_msgs::msg::Twist>::SharedPtr cmd_vel_pub_;
   rclcpp::Publisher<sensor_msgs::msg::JointState>::SharedPtr joint_state_pub_;
   rclcpp::Publisher<geometry_msgs::msg::TwistStamped>::SharedPtr cmd_vel_stamped_pub_;
@@ -70,18 +149,182 @@ private:
   bool publish_stamped_twist_;
   std::string robot_base_frame_;
   std::string control_mode_;
-  bool require_enable_button_;
-  int64_t enable_button_;
-  int64_t enable_turbo_button_;
-  bool inverted_reverse_;
 
-  std::map<std::string, int64_t> axis_chassis_map_;
-  std::map<std::string, std::map<std::string, double>> scale_chassis_map_;
-  std::map<std::string, int64_t> axis_gimbal_map_;
-  std::map<std::string, std::map<std::string, double>> scale_gimbal_map_;
+  // Joystick to command mapping, shared with the offline Python bindings.
+  MappingConfig mapping_config_;
+  TeleopMapper teleop_mapper_;
+
+  // Goals are moved out of obstacles on a cached global costmap before dispatch.
+  bool goal_snap_enable_;
+  int64_t goal_snap_occupied_threshold_;
+  double goal_snap_max_distance_;
+  bool goal_snap_allow_unknown_;
+  // Update windows are applied in place under the mutex. The goal path searches
+  // under it too, which is short: at most max_distance / resolution rings.
+  std::mutex costmap_mutex_;
+  CostmapCache costmap_cache_;
+  rclcpp::Subscription<nav_msgs::msg::OccupancyGrid>::SharedPtr costmap_sub_;
+  rclcpp::Subscription<map_msgs::msg::OccupancyGridUpdate>::SharedPtr costmap_update_sub_;
 
   bool sent_disable_msg_;
-  double dt_;
+
+  // Failures on the joy path are logged rate-limited from a background thread.
+  ThrottledLogger throttled_logger_;
+  size_t tf_failure_log_site_;
+  size_t malformed_joy_log_site_;
+  size_t rc_error_log_site_;
+  size_t goal_blocked_log_site_;
+
+  // All timing runs on the node clock, so /clock may drive it at any rate.
+  int64_t last_input_time_ns_;
+  rclcpp::Time last_goal_time_;
+  rclcpp::JumpHandler::SharedPtr time_jump_handler_;
+  std::atomic<bool> time_jumped_;
+
+  // The joint state message keeps its names and is reused.
+  sensor_msgs::msg::JointState joint_state_msg_;
+
+  // Outputs without matched subscriptions are neither built nor published.
+  bool skip_unsubscribed_outputs_;
+  PublisherHealth cmd_vel_health_;
+  PublisherHealth joint_state_health_;
+  PublisherHealth shoot_health_;
+  rclcpp::TimerBase::SharedPtr publisher_health_timer_;
+
+  // Execution time of the joy processing, reported on diagnostics. Measured on
+  // the steady clock since it is CPU time, not node time.
+  bool statistics_enable_;
+  int64_t callback_budget_ns_;
+  std::mutex statistics_mutex_;
+  DurationHistogram callback_stats_;
+  uint64_t callback_over_budget_;
+  // Age of each joy input (its stamp, set by the driver on the device event)
+  // when its commands have been published, on the node clock.
+  int64_t latency_budget_ns_;
+  DurationHistogram input_latency_stats_;
+  uint64_t input_latency_over_budget_;
+  int64_t last_latency_stamp_ns_;
+  PerfCounters perf_counters_;
+  rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_pub_;
+  rclcpp::TimerBase::SharedPtr statistics_timer_;
+
+  // Candidate mapping run on the live input with its own state. Its commands
+  // go to debug topics only, its cost is reported on diagnostics.
+  bool shadow_enable_;
+  MappingConfig shadow_mapping_config_;
+  TeleopMapper shadow_mapper_;
+  sensor_msgs::msg::JointState shadow_joint_state_msg_;
+  rclcpp::Publisher<geometry_msgs::msg::Twist>::SharedPtr shadow_cmd_vel_pub_;
+  rclcpp::Publisher<sensor_msgs::msg::JointState>::SharedPtr shadow_joint_state_pub_;
+  rclcpp::Publisher<example_interfaces::msg::UInt8>::SharedPtr shadow_shoot_pub_;
+  DurationHistogram shadow_stats_;
+
+  // Predicted joint setpoints over a short horizon, so controllers interpolate
+  // between messages sent at a lower rate than cmd_gimbal_joint.
+  bool trajectory_enable_;
+  int64_t trajectory_period_ns_;
+  int64_t last_trajectory_time_ns_;
+  double trajectory_step_;
+  size_t trajectory_steps_;
+  std::vector<double> trajectory_positions_;
+  std::vector<double> trajectory_velocities_;
+  trajectory_msgs::msg::JointTrajectory trajectory_msg_;
+  rclcpp::Publisher<trajectory_msgs::msg::JointTrajectory>::SharedPtr trajectory_pub_;
+
+  // Joint setpoints and profile mirrored to a file to resume after a restart.
+  RuntimeStateFile runtime_state_file_;
+
+  // Latest command in shared memory for processes without ROS.
+  CommandMailboxWriter command_mailbox_;
+
+  // Formation mode: the chassis command drives a group of robots, each on its
+  // own namespace, instead of cmd_vel.
+  bool formation_enable_;
+  int64_t formation_pose_timeout_ns_;
+  std::mutex formation_mutex_;
+  FormationSolver formation_solver_;
+  std::vector<rclcpp::Subscription<geometry_msgs::msg::PoseStamped>::SharedPtr>
+    formation_pose_subs_;
+  std::vector<rclcpp::Publisher<geometry_msgs::msg::Twist>::SharedPtr> formation_cmd_vel_pubs_;
+
+  // Chassis twists are scaled to the referee power budget, so the chassis runs
+  // at the limit without tripping it.
+  bool power_governor_enable_;
+  std::mutex power_governor_mutex_;
+  PowerGovernor power_governor_;
+  double power_governor_min_scale_;
+  rclcpp::Subscription<example_interfaces::msg::Float64>::SharedPtr chassis_power_sub_;
+  rclcpp::Subscription<example_interfaces::msg::Float64>::SharedPtr buffer_energy_sub_;
+  rclcpp::Subscription<example_interfaces::msg::Float64>::SharedPtr power_limit_sub_;
+
+  // Pipeline mode: decoding, mapping and output each run on their own thread,
+  // handing over through lock-free rings, so a slow publish or TF lookup does
+  // not hold up the next input.
+  enum PipelineStage
+  {
+    PIPELINE_DECODE,
+    PIPELINE_MAPPING,
+    PIPELINE_OUTPUT,
+    NUM_PIPELINE_STAGES,
+  };
+  struct PipelineInput
+  {
+    sensor_msgs::msg::Joy::SharedPtr joy_msg;
+    std::shared_ptr<rclcpp::SerializedMessage> serialized_msg;
+    int64_t received_ns;
+  };
+  struct PipelineJoy
+  {
+    JoySnapshot joy;
+    int64_t received_ns;
+    int64_t queued_ns;
+  };
+  struct PipelineCommand
+  {
+    TeleopCommand command;
+    std::vector<double> joints;
+    JoySnapshot joy;
+    double dt;
+    int64_t received_ns;
+    int64_t queued_ns;
+  };
+  struct PipelineStageStats
+  {
+    // Queue wait plus processing, per item.
+    DurationHistogram latency;
+    size_t max_queue_depth = 0;
+  };
+  bool pipeline_enable_;
+  std::vector<int64_t> pipeline_cpus_;
+  std::unique_ptr<SpscRing<PipelineInput>> pipeline_input_ring_;
+  std::unique_ptr<SpscRing<PipelineJoy>> pipeline_joy_ring_;
+  std::unique_ptr<SpscRing<PipelineCommand>> pipeline_command_ring_;
+  std::atomic<uint64_t> pipeline_dropped_[NUM_PIPELINE_STAGES];
+  PipelineStageStats pipeline_stats_[NUM_PIPELINE_STAGES];
+  std::thread pipeline_threads_[NUM_PIPELINE_STAGES];
+  std::atomic<bool> pipeline_stop_;
+
+  // Phase-locked output: joy input is latched and processed right before the
+  // downstream controller samples its command.
+  bool phase_lock_enable_;
+  double phase_lock_input_timeout_;
+  rclcpp::Subscription<sensor_msgs::msg::JointState>::SharedPtr controller_tick_sub_;
+  rclcpp::Publisher<example_interfaces::msg::Float64>::SharedPtr phase_error_pub_;
+  std::unique_ptr<PhaseLock> phase_lock_;
+  std::mutex phase_lock_mutex_;
+  JoySnapshot latest_joy_;
+  bool latest_joy_valid_;
+  rclcpp::Time latest_joy_time_;
+  std::thread phase_lock_thread_;
+  std::atomic<bool> phase_lock_stop_;
+  // The wait for the next publish runs on the steady clock, woken early by
+  // simulation clock updates, so a paused /clock cannot block shutdown.
+  std::mutex phase_lock_wait_mutex_;
+  std::condition_variable phase_lock_wait_cv_;
+  // Set under the wait mutex when a backwards jump reset the lock, the pending
+  // target is then stale.
+  bool phase_lock_rescheduled_;
+  rclcpp::JumpHandler::SharedPtr phase_lock_clock_handler_;
 };
 
 }  // namespace pb_teleop_twist_joy
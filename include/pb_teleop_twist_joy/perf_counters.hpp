@@ -0,0 +1,125 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__PERF_COUNTERS_HPP_
+#define PB_TELEOP_TWIST_JOY__PERF_COUNTERS_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace pb_teleop_twist_joy
+{
+
+enum class PerfStage
+{
+  TOTAL,
+  MAPPING,
+  FILL,
+  PUBLISH,
+  TF,
+  GOAL,
+};
+constexpr size_t NUM_PERF_STAGES = 6;
+const char * perfStageName(PerfStage stage);
+
+enum PerfEvent
+{
+  PERF_CYCLES,
+  PERF_INSTRUCTIONS,
+  PERF_CACHE_MISSES,
+  PERF_BRANCH_MISSES,
+  NUM_PERF_EVENTS,
+};
+
+struct PerfReading
+{
+  uint64_t values[NUM_PERF_EVENTS];
+};
+
+struct PerfStageTotals
+{
+  uint64_t runs = 0;
+  uint64_t values[NUM_PERF_EVENTS] = {};
+  // Events the hardware could not count stay false and read as zero.
+  bool counted[NUM_PERF_EVENTS] = {};
+};
+
+// Hardware counters of the thread that first calls begin(), opened lazily as
+// one perf_event group and aggregated per stage. When the kernel refuses the
+// counters (no PMU, perf_event_paranoid) every call degrades to a no-op.
+class PerfCounters
+{
+public:
+  PerfCounters();
+  ~PerfCounters();
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters & operator=(const PerfCounters &) = delete;
+
+  void setEnabled(bool enabled) { enabled_ = enabled; }
+  bool unavailable() const { return failed_; }
+  const std::string & error() const { return error_; }
+
+  bool begin(PerfReading * reading);
+  void end(PerfStage stage, const PerfReading & begin_reading);
+
+  // Copy the totals accumulated since the last call and start over.
+  void collect(PerfStageTotals * totals);
+
+private:
+  bool open();
+  bool read(PerfReading * reading);
+
+  bool enabled_;
+  bool opened_;
+  std::atomic<bool> failed_;
+  std::string error_;
+  int fds_[NUM_PERF_EVENTS];
+  // Position of each opened event in the group read buffer, -1 if not counted.
+  int slot_[NUM_PERF_EVENTS];
+  size_t num_opened_;
+
+  std::mutex mutex_;
+  PerfStageTotals totals_[NUM_PERF_STAGES];
+};
+
+// Samples the counters around a scope when instrumentation is active.
+class PerfScope
+{
+public:
+  PerfScope(PerfCounters * counters, PerfStage stage)
+  : counters_(counters), stage_(stage), active_(counters->begin(&start_))
+  {
+  }
+  ~PerfScope()
+  {
+    if (active_) {
+      counters_->end(stage_, start_);
+    }
+  }
+  PerfScope(const PerfScope &) = delete;
+  PerfScope & operator=(const PerfScope &) = delete;
+
+private:
+  PerfCounters * counters_;
+  PerfStage stage_;
+  PerfReading start_;
+  bool active_;
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__PERF_COUNTERS_HPP_
@@ -0,0 +1,69 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__PHASE_LOCK_HPP_
+#define PB_TELEOP_TWIST_JOY__PHASE_LOCK_HPP_
+
+#include <cstdint>
+
+namespace pb_teleop_twist_joy
+{
+
+// Tracks the sample instants of a downstream periodic controller and schedules
+// output so that it lands `offset_ns` before one of those instants.
+// All times are in nanoseconds of the same clock.
+class PhaseLock
+{
+public:
+  PhaseLock(int64_t period_ns, int64_t offset_ns, int64_t divider);
+
+  // Feed one observed controller sample instant. Returns true and sets
+  // `phase_error_ns` when the tick can be matched with the last publish, the
+  // error being positive when the output arrived earlier than requested.
+  bool onTick(int64_t tick_ns, int64_t * phase_error_ns);
+
+  // Next instant at which output should be published, strictly after `now_ns`.
+  int64_t nextPublishTime(int64_t now_ns);
+
+  void notePublished(int64_t publish_ns);
+
+  // Drop the lock and the pending schedule, e.g. after the clock went backwards.
+  // The period estimate is kept. onTick() resets on its own when the ticks jump
+  // back by more than a period.
+  void reset();
+
+  // Number of resets so far, a caller waiting on nextPublishTime() re-plans when it changes.
+  uint64_t resets() const { return resets_; }
+
+  bool locked() const { return has_tick_; }
+  int64_t period() const { return period_ns_; }
+
+private:
+  int64_t nextSampleAfter(int64_t t_ns) const;
+
+  int64_t nominal_period_ns_;
+  int64_t offset_ns_;
+  int64_t divider_;
+
+  bool has_tick_;
+  int64_t tick_ns_;
+  int64_t period_ns_;
+  int64_t next_target_ns_;
+  int64_t last_publish_ns_;
+  uint64_t resets_;
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__PHASE_LOCK_HPP_
@@ -0,0 +1,96 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__POWER_GOVERNOR_HPP_
+#define PB_TELEOP_TWIST_JOY__POWER_GOVERNOR_HPP_
+
+#include <cstdint>
+
+namespace pb_teleop_twist_joy
+{
+
+struct PowerGovernorConfig
+{
+  // Chassis draw at standstill, W.
+  double static_power = 0.0;
+  // Per axis draw a * |v| + b * v^2 for linear x, linear y and angular z.
+  double linear_coefficients[3] = {};
+  double quadratic_coefficients[3] = {};
+  // Used until the referee sends a limit, W.
+  double default_limit = 0.0;
+  // Buffer energy held back for bursts the model misses, J.
+  double buffer_reserve = 0.0;
+  // Buffer energy above the reserve is spent over this time, s.
+  double buffer_horizon = 1.0;
+  // Telemetry older than this is ignored, ns.
+  int64_t telemetry_timeout_ns = 0;
+  // Weight of a power sample in the model correction, 0 keeps the model fixed.
+  double correction_rate = 0.0;
+  double min_correction = 0.5;
+  double max_correction = 2.0;
+};
+
+// Scales chassis twists so the predicted power stays within the referee budget:
+// the power limit plus the buffer energy above the reserve, spread over the
+// buffer horizon. Below the reserve the budget drops under the limit, so the
+// buffer refills. Measured power corrects the model by a common factor, which
+// absorbs battery voltage and wear the fixed coefficients cannot know.
+class PowerGovernor
+{
+public:
+  void configure(const PowerGovernorConfig & config);
+
+  // Power samples only correct the model while a twist governed within the
+  // telemetry timeout explains them.
+  void setPower(double power, int64_t now_ns);
+  void setBuffer(double energy, int64_t now_ns);
+  void setLimit(double limit);
+
+  // Scales the twist in place, keeping its direction. Returns the scale, 1 when
+  // the twist fits the budget.
+  double govern(double * linear_x, double * linear_y, double * angular_z, int64_t now_ns);
+
+  // The chassis was told to stop without a governed twist: predicts standstill
+  // and holds the correction until the next govern().
+  void release();
+
+  double budget() const { return budget_; }
+  double predictedPower() const { return predicted_power_; }
+  double correction() const { return correction_; }
+  double limit() const { return limit_; }
+  double buffer() const { return buffer_; }
+  bool bufferFresh(int64_t now_ns) const { return fresh(buffer_ns_, now_ns); }
+  bool powerFresh(int64_t now_ns) const { return fresh(power_ns_, now_ns); }
+
+private:
+  bool fresh(int64_t stamp_ns, int64_t now_ns) const
+  {
+    return stamp_ns != 0 && now_ns - stamp_ns <= config_.telemetry_timeout_ns;
+  }
+
+  PowerGovernorConfig config_;
+  double correction_ = 1.0;
+  double limit_ = 0.0;
+  double buffer_ = 0.0;
+  int64_t power_ns_ = 0;
+  int64_t buffer_ns_ = 0;
+  double budget_ = 0.0;
+  // Model power of the last governed twist, what the next sample is checked on.
+  double predicted_power_ = 0.0;
+  int64_t governed_ns_ = 0;
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__POWER_GOVERNOR_HPP_
@@ -0,0 +1,95 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__PUBLISHER_HEALTH_HPP_
+#define PB_TELEOP_TWIST_JOY__PUBLISHER_HEALTH_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "rclcpp/rclcpp.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+// Matched subscriptions, QoS events and publish latency of one output
+// publisher. Event counters are written from the executor, the subscription
+// count from the poll timer, and both are read on the hot path.
+//
+// Publish latency is the backpressure signal: a reliable writer whose history
+// is full of samples a slow reader has not acknowledged blocks in publish()
+// (or drops, depending on the middleware), so slow publishes with matched
+// subscriptions mean a consumer is not keeping up.
+class PublisherHealth
+{
+public:
+  explicit PublisherHealth(const std::string & topic);
+
+  // Publisher options with QoS event callbacks wired into this object.
+  rclcpp::PublisherOptions makeOptions();
+
+  // Publishes taking longer than this count as slow, 0 disables the check.
+  void setSlowPublishThreshold(int64_t threshold_ns) { slow_publish_ns_ = threshold_ns; }
+
+  // Record the time one publish() call took, from the hot path.
+  void recordPublish(int64_t duration_ns);
+
+  // Refresh the matched subscription count, close the publish latency window
+  // and report new QoS events and slow publishes.
+  void poll(const rclcpp::PublisherBase & publisher, const rclcpp::Logger & logger);
+
+  bool hasSubscribers() const { return subscription_count_.load(std::memory_order_relaxed) > 0; }
+  size_t subscriptionCount() const { return subscription_count_.load(std::memory_order_relaxed); }
+  const std::string & topic() const { return topic_; }
+
+  // Publish figures of the last closed poll window.
+  uint64_t windowPublishes() const { return window_publishes_.load(std::memory_order_relaxed); }
+  uint64_t windowSlowPublishes() const
+  {
+    return window_slow_publishes_.load(std::memory_order_relaxed);
+  }
+  int64_t windowMaxPublishNs() const
+  {
+    return window_max_publish_ns_.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::string topic_;
+  std::atomic<size_t> subscription_count_;
+  std::atomic<uint64_t> deadline_missed_;
+  std::atomic<uint64_t> liveliness_lost_;
+  std::atomic<uint64_t> incompatible_qos_;
+  // rmw_qos_policy_kind_t of the last incompatibility.
+  std::atomic<int> incompatible_policy_;
+
+  int64_t slow_publish_ns_;
+  std::atomic<uint64_t> publishes_;
+  std::atomic<uint64_t> slow_publishes_;
+  std::atomic<int64_t> max_publish_ns_;
+  std::atomic<uint64_t> window_publishes_;
+  std::atomic<uint64_t> window_slow_publishes_;
+  std::atomic<int64_t> window_max_publish_ns_;
+
+  bool polled_;
+  uint64_t reported_deadline_missed_;
+  uint64_t reported_liveliness_lost_;
+  uint64_t reported_incompatible_qos_;
+  uint64_t reported_publishes_;
+  uint64_t reported_slow_publishes_;
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__PUBLISHER_HEALTH_HPP_
@@ -0,0 +1,84 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__RC_FRAME_DECODER_HPP_
+#define PB_TELEOP_TWIST_JOY__RC_FRAME_DECODER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "pb_teleop_twist_joy/joy_snapshot.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+enum class RcProtocol
+{
+  // DJI DR16 receiver, 18 byte frames without header.
+  DBUS,
+  // Futaba S.BUS, 25 byte frames between 0x0F and 0x00.
+  SBUS,
+};
+
+// Turns the byte stream of an RC receiver into joy snapshots.
+//
+// DBUS axes: right stick horizontal and vertical, left stick horizontal and
+// vertical, wheel, mouse x, y and z. Buttons: left switch up, middle, down,
+// right switch up, middle, down, mouse left, right, then the 16 keyboard keys
+// W S A D Shift Ctrl Q E R F G Z X C V B.
+//
+// SBUS axes: the 16 channels. Buttons: channel 17, channel 18, then low,
+// middle and high positions of channels 5 to 14, where switches usually sit.
+//
+// Channels are scaled to [-1, 1], mouse axes are raw counts. A frame with the
+// failsafe flag yields released input, so the node stops the robot. A frame
+// flagged lost still carries the last channels the receiver got, only a run of
+// MAX_LOST_FRAMES of them releases the input.
+class RcFrameDecoder
+{
+public:
+  static constexpr size_t MAX_FRAME_SIZE = 25;
+  static constexpr uint32_t MAX_LOST_FRAMES = 10;
+
+  explicit RcFrameDecoder(RcProtocol protocol);
+
+  size_t frameSize() const { return frame_size_; }
+
+  // Call on every inter-frame gap of the line, DBUS frames are only delimited
+  // by these.
+  void resync();
+
+  // Returns true when `byte` completed a valid frame, decoded into `joy`.
+  bool push(uint8_t byte, JoySnapshot * joy);
+
+  uint64_t invalidFrames() const { return invalid_frames_; }
+
+private:
+  bool decodeDbus(JoySnapshot * joy) const;
+  bool decodeSbus(JoySnapshot * joy);
+
+  RcProtocol protocol_;
+  size_t frame_size_;
+  uint8_t frame_[MAX_FRAME_SIZE];
+  size_t length_;
+  // DBUS only: bytes are ignored after a bad frame until the next gap.
+  bool synced_;
+  uint64_t invalid_frames_;
+  // SBUS only: consecutive frames flagged lost.
+  uint32_t lost_frames_;
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__RC_FRAME_DECODER_HPP_
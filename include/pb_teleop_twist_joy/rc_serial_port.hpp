@@ -0,0 +1,57 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__RC_SERIAL_PORT_HPP_
+#define PB_TELEOP_TWIST_JOY__RC_SERIAL_PORT_HPP_
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "pb_teleop_twist_joy/rc_frame_decoder.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+// Non-blocking serial port set up for an RC receiver: 100000 baud, 8 data
+// bits, even parity, one stop bit for DBUS and two for SBUS. The signal
+// inversion of both protocols is left to the hardware. Bytes with parity
+// errors are dropped, which breaks the frame and makes the decoder resync.
+// Pseudo-terminals accept the settings, so recorded frames can be replayed.
+class RcSerialPort
+{
+public:
+  RcSerialPort() = default;
+  ~RcSerialPort();
+  RcSerialPort(const RcSerialPort &) = delete;
+  RcSerialPort & operator=(const RcSerialPort &) = delete;
+
+  // On failure returns false and describes why in `error`.
+  bool open(const std::string & device, RcProtocol protocol, std::string * error);
+  void close();
+  bool isOpen() const { return fd_ >= 0; }
+
+  // Waits up to timeout_ms for data. Returns the number of bytes read, 0 on
+  // timeout and -1 on error with errno set.
+  ssize_t read(uint8_t * buffer, size_t size, int timeout_ms);
+
+private:
+  int fd_ = -1;
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__RC_SERIAL_PORT_HPP_
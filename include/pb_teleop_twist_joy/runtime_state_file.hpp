@@ -0,0 +1,83 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__RUNTIME_STATE_FILE_HPP_
+#define PB_TELEOP_TWIST_JOY__RUNTIME_STATE_FILE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pb_teleop_twist_joy/mapping_core.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+// Mirror of the runtime state in a memory-mapped file, so a restarted node
+// resumes from the last setpoints. Two checksummed slots are written in turn,
+// so a process dying mid-write leaves the previous state intact. Saved states
+// are stamped on CLOCK_BOOTTIME together with the boot id, and the joint names
+// must match for a state to be restored.
+class RuntimeStateFile
+{
+public:
+  static constexpr size_t MAX_JOINTS = 64;
+
+  RuntimeStateFile() = default;
+  ~RuntimeStateFile();
+  RuntimeStateFile(const RuntimeStateFile &) = delete;
+  RuntimeStateFile & operator=(const RuntimeStateFile &) = delete;
+
+  // On failure returns false and describes why in `error`.
+  bool open(
+    const std::string & path, const std::vector<std::string> & joint_names, std::string * error);
+
+  bool isOpen() const { return file_ != nullptr; }
+
+  // The newest intact state saved for the same joints less than max_age_ns ago
+  // in this boot. Returns false when there is none.
+  bool restore(int64_t max_age_ns, std::vector<double> * joints, SpeedProfile * profile) const;
+
+  void save(const std::vector<double> & joints, SpeedProfile profile);
+
+private:
+  struct Slot
+  {
+    uint64_t sequence;
+    int64_t saved_ns;
+    int32_t profile;
+    uint32_t num_joints;
+    double joints[MAX_JOINTS];
+    uint64_t checksum;
+  };
+
+  struct File
+  {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t joints_hash;
+    char boot_id[40];
+    Slot slots[2];
+  };
+
+  File * file_ = nullptr;
+  uint64_t joints_hash_ = 0;
+  char boot_id_[40] = {};
+  uint64_t sequence_ = 0;
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__RUNTIME_STATE_FILE_HPP_
@@ -0,0 +1,134 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__SPSC_RING_HPP_
+#define PB_TELEOP_TWIST_JOY__SPSC_RING_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace pb_teleop_twist_joy
+{
+
+// Bounded lock-free ring between exactly one producer and one consumer thread.
+// Slots are constructed once and reused in place, so items holding buffers do
+// not allocate per hand-over. An idle consumer sleeps in wait(), the producer
+// only takes the mutex to wake it when it actually sleeps.
+template <typename T>
+class SpscRing
+{
+public:
+  // `capacity` is rounded up to a power of two, `prototype` initializes the slots.
+  explicit SpscRing(size_t capacity, const T & prototype = T())
+  : mask_(roundUpPowerOfTwo(capacity) - 1), slots_(mask_ + 1, prototype)
+  {
+    head_.value.store(0, std::memory_order_relaxed);
+    tail_.value.store(0, std::memory_order_relaxed);
+    consumer_waiting_.value.store(false, std::memory_order_relaxed);
+  }
+  SpscRing(const SpscRing &) = delete;
+  SpscRing & operator=(const SpscRing &) = delete;
+
+  size_t capacity() const { return mask_ + 1; }
+  size_t size() const
+  {
+    return tail_.value.load(std::memory_order_acquire) -
+           head_.value.load(std::memory_order_acquire);
+  }
+
+  // Producer: the slot to fill, nullptr when the ring is full.
+  T * producerSlot()
+  {
+    size_t tail = tail_.value.load(std::memory_order_relaxed);
+    if (tail - head_.value.load(std::memory_order_acquire) > mask_) {
+      return nullptr;
+    }
+    return &slots_[tail & mask_];
+  }
+
+  // Producer: hands the filled slot over.
+  void push()
+  {
+    // Sequentially consistent, paired with the consumer going to sleep.
+    tail_.value.fetch_add(1, std::memory_order_seq_cst);
+    if (consumer_waiting_.value.load(std::memory_order_seq_cst)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cv_.notify_one();
+    }
+  }
+
+  // Consumer: the oldest item, nullptr when the ring is empty.
+  T * consumerSlot()
+  {
+    size_t head = head_.value.load(std::memory_order_relaxed);
+    if (head == tail_.value.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return &slots_[head & mask_];
+  }
+
+  // Consumer: releases the slot to the producer.
+  void pop() { head_.value.fetch_add(1, std::memory_order_release); }
+
+  // Consumer: sleeps until an item is there or the timeout passed. Returns
+  // false on timeout.
+  bool wait(std::chrono::nanoseconds timeout)
+  {
+    if (consumerSlot() != nullptr) {
+      return true;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    consumer_waiting_.value.store(true, std::memory_order_seq_cst);
+    bool ready = cv_.wait_for(lock, timeout, [this]() {
+      return tail_.value.load(std::memory_order_seq_cst) !=
+             head_.value.load(std::memory_order_relaxed);
+    });
+    consumer_waiting_.value.store(false, std::memory_order_relaxed);
+    return ready;
+  }
+
+private:
+  // Producer and consumer indices on their own cache lines.
+  template <typename U>
+  struct CacheLine
+  {
+    std::atomic<U> value;
+    char padding[64 - sizeof(std::atomic<U>)];
+  };
+
+  static size_t roundUpPowerOfTwo(size_t value)
+  {
+    size_t result = 1;
+    while (result < value) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  size_t mask_;
+  std::vector<T> slots_;
+  CacheLine<size_t> head_;
+  CacheLine<size_t> tail_;
+  CacheLine<bool> consumer_waiting_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__SPSC_RING_HPP_
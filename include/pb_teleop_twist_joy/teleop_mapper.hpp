@@ -0,0 +1,110 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__TELEOP_MAPPER_HPP_
+#define PB_TELEOP_TWIST_JOY__TELEOP_MAPPER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "pb_teleop_twist_joy/joint_mapper.hpp"
+#include "pb_teleop_twist_joy/joy_snapshot.hpp"
+#include "pb_teleop_twist_joy/mapping_config.hpp"
+#include "pb_teleop_twist_joy/mapping_core.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+struct TeleopCommand
+{
+  SpeedProfile profile = SpeedProfile::DISABLED;
+  double chassis[NUM_CHASSIS_AXES] = {};
+  double shoot = 0.0;
+};
+
+// Row-major input and output arrays of TeleopMapper::mapBatch(). Strides are
+// in elements. Output pointers may be null to skip that output.
+struct BatchInput
+{
+  size_t rows = 0;
+  const float * axes = nullptr;
+  size_t num_axes = 0;
+  size_t axes_stride = 0;
+  const int32_t * buttons = nullptr;
+  size_t num_buttons = 0;
+  size_t buttons_stride = 0;
+  // Seconds, one per row.
+  const double * stamps = nullptr;
+};
+
+struct BatchOutput
+{
+  int8_t * profile = nullptr;
+  // rows x NUM_CHASSIS_AXES.
+  double * chassis = nullptr;
+  // rows x number of joints.
+  double * joints = nullptr;
+  double * shoot = nullptr;
+};
+
+// The joystick to command mapping of the node without any ROS dependency, so
+// that offline tools run exactly the code the robot runs.
+class TeleopMapper
+{
+public:
+  // Returns false when the joint output indices are not a permutation, see
+  // JointMapper::configure().
+  bool configure(const MappingConfig & config);
+
+  // One joy input. Joints only move while enabled, as the robot does.
+  void map(const JoySnapshot & joy, double dt, TeleopCommand * command);
+
+  // Joint setpoints predicted from `start` while `joy` is held with `profile`,
+  // see JointMapper::predict(). Disabled joints hold still.
+  void predictJoints(
+    const std::vector<double> & start, const JoySnapshot & joy, SpeedProfile profile, double step,
+    size_t num_steps, double * positions, double * velocities) const;
+
+  // Replays a recorded session, integrating on the row stamps the way the node
+  // integrates on the joy stamps. Consecutive calls continue one session, the
+  // first row integrates from the last stamp of the previous call. configure()
+  // starts a new session.
+  void mapBatch(const BatchInput & input, const BatchOutput & output);
+
+  const JointMapper & joints() const { return joints_; }
+  JointMapper & joints() { return joints_; }
+  double maxIntegrationDt() const { return max_integration_dt_; }
+
+private:
+  bool require_enable_button_ = true;
+  int64_t enable_button_ = -1;
+  int64_t enable_turbo_button_ = -1;
+  bool inverted_reverse_ = false;
+  double max_integration_dt_ = 0.1;
+  bool has_batch_stamp_ = false;
+  double last_batch_stamp_ = 0.0;
+
+  int64_t chassis_axis_[NUM_CHASSIS_AXES] = {};
+  // [profile][axis], profile 0 is normal and 1 turbo.
+  double chassis_scale_[2][NUM_CHASSIS_AXES] = {};
+  int64_t shoot_axis_ = -1;
+  double shoot_scale_ = 0.0;
+
+  JointMapper joints_;
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__TELEOP_MAPPER_HPP_
@@ -0,0 +1,91 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef PB_TELEOP_TWIST_JOY__THROTTLED_LOGGER_HPP_
+#define PB_TELEOP_TWIST_JOY__THROTTLED_LOGGER_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "rclcpp/rclcpp.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+// Logger for diagnostics raised on the control path. A call only checks the
+// per call site rate limit and copies its arguments into a preallocated ring;
+// formatting and the actual console/rosout write happen on a background
+// thread. Messages dropped by the rate limit are counted and summarized.
+class ThrottledLogger
+{
+public:
+  static constexpr size_t MAX_SITES = 16;
+  static constexpr size_t RING_SIZE = 32;
+  static constexpr size_t MAX_ARG_LENGTH = 128;
+  static constexpr size_t MAX_MESSAGE_LENGTH = 512;
+
+  explicit ThrottledLogger(const rclcpp::Logger & logger);
+  ~ThrottledLogger();
+  ThrottledLogger(const ThrottledLogger &) = delete;
+  ThrottledLogger & operator=(const ThrottledLogger &) = delete;
+
+  // Register a call site once, off the hot path. `format` must outlive the
+  // logger and take at most two string arguments.
+  size_t registerSite(RCUTILS_LOG_SEVERITY severity, const char * format, double period);
+
+  void log(size_t site, const char * arg0 = "", const char * arg1 = "");
+
+private:
+  struct Site
+  {
+    RCUTILS_LOG_SEVERITY severity;
+    const char * format;
+    int64_t period_ns;
+    std::atomic<int64_t> next_allowed_ns;
+    std::atomic<uint64_t> suppressed;
+  };
+
+  struct Record
+  {
+    size_t site;
+    uint64_t suppressed;
+    char args[2][MAX_ARG_LENGTH];
+  };
+
+  void run();
+  void write(const Site & site, const char * message);
+
+  rclcpp::Logger logger_;
+  Site sites_[MAX_SITES];
+  std::atomic<size_t> num_sites_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  Record ring_[RING_SIZE];
+  size_t head_;
+  size_t tail_;
+  bool stop_;
+  std::thread thread_;
+
+  // Last text written per site, owned by the writer thread.
+  char last_messages_[MAX_SITES][MAX_MESSAGE_LENGTH];
+};
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // PB_TELEOP_TWIST_JOY__THROTTLED_LOGGER_HPP_
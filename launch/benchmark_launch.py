@@ -0,0 +1,86 @@
+# Copyright 2025 Lihan Chen
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import os
+
+from ament_index_python.packages import get_package_share_directory
+from launch import LaunchDescription
+from launch.actions import DeclareLaunchArgument, EmitEvent, RegisterEventHandler
+from launch.event_handlers import OnProcessExit
+from launch.events import Shutdown
+from launch.substitutions import LaunchConfiguration
+from launch_ros.actions import Node
+
+
+def generate_launch_description():
+    # One benchmark run under the RMW and transport set in the environment, see
+    # `teleop_benchmark.py matrix`.
+    result_file = LaunchConfiguration("result_file")
+    rate = LaunchConfiguration("rate")
+    duration = LaunchConfiguration("duration")
+    config_filepath = LaunchConfiguration("config_filepath")
+
+    declare_result_file_cmd = DeclareLaunchArgument("result_file")
+    declare_rate_cmd = DeclareLaunchArgument("rate", default_value="200.0")
+    declare_duration_cmd = DeclareLaunchArgument("duration", default_value="10.0")
+    declare_config_filepath_cmd = DeclareLaunchArgument(
+        "config_filepath",
+        default_value=os.path.join(
+            get_package_share_directory("pb_teleop_twist_joy"),
+            "config",
+            "xbox.config.yaml",
+        ),
+    )
+
+    teleop_twist_joy_node = Node(
+        package="pb_teleop_twist_joy",
+        executable="pb_teleop_twist_joy_node",
+        name="pb_teleop_twist_joy",
+        parameters=[config_filepath],
+    )
+
+    benchmark_probe = Node(
+        package="pb_teleop_twist_joy",
+        executable="teleop_benchmark.py",
+        name="teleop_benchmark_probe",
+        arguments=[
+            "probe",
+            "--result-file",
+            result_file,
+            "--rate",
+            rate,
+            "--duration",
+            duration,
+        ],
+    )
+
+    # The run ends with the probe.
+    shutdown_on_probe_exit = RegisterEventHandler(
+        OnProcessExit(
+            target_action=benchmark_probe, on_exit=[EmitEvent(event=Shutdown())]
+        )
+    )
+
+    ld = LaunchDescription()
+
+    ld.add_action(declare_result_file_cmd)
+    ld.add_action(declare_rate_cmd)
+    ld.add_action(declare_duration_cmd)
+    ld.add_action(declare_config_filepath_cmd)
+
+    ld.add_action(teleop_twist_joy_node)
+    ld.add_action(benchmark_probe)
+    ld.add_action(shutdown_on_probe_exit)
+
+    return ld
@@ -0,0 +1,205 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "pb_teleop_twist_joy/mapping_config.hpp"
+#include "pb_teleop_twist_joy/teleop_mapper.hpp"
+
+namespace py = pybind11;
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+void warn(const std::string & message)
+{
+  if (PyErr_WarnEx(PyExc_UserWarning, message.c_str(), 1) < 0) {
+    throw py::error_already_set();
+  }
+}
+
+// Mapping parameters from a dict laid out like the config YAML: nested dicts or
+// dotted keys, optionally below a node name and "ros__parameters".
+class DictParameterSource : public ParameterSource
+{
+public:
+  explicit DictParameterSource(const py::dict & parameters) { flatten("", parameters); }
+
+  bool getBool(const std::string & name, bool default_value) override
+  {
+    return get(name, default_value);
+  }
+  int64_t getInt(const std::string & name, int64_t default_value) override
+  {
+    return get(name, default_value);
+  }
+  double getDouble(const std::string & name, double default_value) override
+  {
+    return get(name, default_value);
+  }
+  std::string getString(const std::string & name, const std::string & default_value) override
+  {
+    return get(name, default_value);
+  }
+  std::vector<std::string> getStringArray(
+    const std::string & name, const std::vector<std::string> & default_value) override
+  {
+    return get(name, default_value);
+  }
+
+private:
+  void flatten(const std::string & prefix, const py::dict & parameters)
+  {
+    for (const auto & item : parameters) {
+      std::string key = py::str(item.first);
+      if (key == "ros__parameters") {
+        flatten("", py::reinterpret_borrow<py::dict>(item.second));
+      } else if (py::isinstance<py::dict>(item.second)) {
+        flatten(prefix + key + ".", py::reinterpret_borrow<py::dict>(item.second));
+      } else {
+        values_[prefix + key] = py::reinterpret_borrow<py::object>(item.second);
+      }
+    }
+  }
+
+  template <typename T>
+  T get(const std::string & name, const T & default_value)
+  {
+    auto it = values_.find(name);
+    if (it == values_.end()) {
+      return default_value;
+    }
+    try {
+      return it->second.cast<T>();
+    } catch (const py::cast_error &) {
+      throw py::type_error("Parameter '" + name + "' has the wrong type.");
+    }
+  }
+
+  std::map<std::string, py::object> values_;
+};
+
+using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+using IntArray = py::array_t<int32_t, py::array::c_style | py::array::forcecast>;
+using DoubleArray = py::array_t<double, py::array::c_style | py::array::forcecast>;
+
+// The node's mapping, fed from recorded joy samples instead of a topic.
+class Mapper
+{
+public:
+  explicit Mapper(const py::dict & parameters)
+  {
+    DictParameterSource source(parameters);
+    config_ = loadMappingConfig(&source);
+    for (const auto & warning : config_.warnings) {
+      warn(warning);
+    }
+    reset();
+  }
+
+  // Restarts the joint integrators from zero and starts a new session.
+  void reset()
+  {
+    if (!mapper_.configure(config_)) {
+      warn("Joint output indices are not a permutation, using list order.");
+    }
+  }
+
+  // Inputs that already are C-contiguous arrays of the right type are read in
+  // place. Consecutive calls continue one session, so mapping a recording in
+  // chunks gives the same result as mapping it at once.
+  py::dict mapBatch(const FloatArray & axes, const IntArray & buttons, const DoubleArray & stamps)
+  {
+    if (axes.ndim() != 2 || buttons.ndim() != 2 || stamps.ndim() != 1) {
+      throw py::value_error("Expected axes (N, A), buttons (N, B) and stamps (N,).");
+    }
+    const py::ssize_t rows = axes.shape(0);
+    if (buttons.shape(0) != rows || stamps.shape(0) != rows) {
+      throw py::value_error("axes, buttons and stamps must have the same number of rows.");
+    }
+
+    BatchInput input;
+    input.rows = static_cast<size_t>(rows);
+    input.axes = axes.data();
+    input.num_axes = static_cast<size_t>(axes.shape(1));
+    input.axes_stride = input.num_axes;
+    input.buttons = buttons.data();
+    input.num_buttons = static_cast<size_t>(buttons.shape(1));
+    input.buttons_stride = input.num_buttons;
+    input.stamps = stamps.data();
+
+    // Results are written straight into the returned arrays.
+    const auto num_joints = static_cast<py::ssize_t>(mapper_.joints().size());
+    py::array_t<int8_t> profile(rows);
+    py::array_t<double> chassis(std::vector<py::ssize_t>{rows, NUM_CHASSIS_AXES});
+    py::array_t<double> joints(std::vector<py::ssize_t>{rows, num_joints});
+    py::array_t<double> shoot(rows);
+    BatchOutput output;
+    output.profile = profile.mutable_data();
+    output.chassis = chassis.mutable_data();
+    output.joints = joints.mutable_data();
+    output.shoot = shoot.mutable_data();
+    {
+      py::gil_scoped_release release;
+      mapper_.mapBatch(input, output);
+    }
+
+    py::dict result;
+    result["profile"] = profile;
+    result["chassis"] = chassis;
+    result["joints"] = joints;
+    result["shoot"] = shoot;
+    return result;
+  }
+
+  const std::vector<std::string> & jointNames() const { return mapper_.joints().names(); }
+
+private:
+  MappingConfig config_;
+  TeleopMapper mapper_;
+};
+}  // namespace
+
+}  // namespace pb_teleop_twist_joy
+
+PYBIND11_MODULE(pb_teleop_twist_joy_py, m)
+{
+  using pb_teleop_twist_joy::Mapper;
+  using pb_teleop_twist_joy::SpeedProfile;
+
+  m.doc() = "Batch access to the pb_teleop_twist_joy joystick mapping for offline analysis.";
+  m.attr("DISABLED") = static_cast<int>(SpeedProfile::DISABLED);
+  m.attr("NORMAL") = static_cast<int>(SpeedProfile::NORMAL);
+  m.attr("TURBO") = static_cast<int>(SpeedProfile::TURBO);
+  m.attr("CHASSIS_AXES") =
+    py::make_tuple("linear_x", "linear_y", "linear_z", "angular_x", "angular_y", "angular_z");
+
+  py::class_<Mapper>(m, "Mapper")
+    .def(py::init<const py::dict &>(), py::arg("parameters"))
+    .def(
+      "map_batch", &Mapper::mapBatch, py::arg("axes"), py::arg("buttons"), py::arg("stamps"),
+      "Maps N joy samples; stamps in seconds. Returns a dict of profile (N,), chassis "
+      "(N, 6), joints (N, J) and shoot (N,) arrays. Continues the session of the previous "
+      "call until reset().")
+    .def("reset", &Mapper::reset, "Restarts the joints from zero and starts a new session.")
+    .def_property_readonly("joint_names", &Mapper::jointNames);
+}
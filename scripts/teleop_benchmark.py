@@ -0,0 +1,307 @@
+#!/usr/bin/env python3
+# Copyright 2025 Lihan Chen
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Latency, CPU and drop benchmark of the teleop topics across RMWs and transports.
+
+`probe` drives a running node with joy messages and measures its outputs, it is
+started by benchmark_launch.py. `matrix` runs that launch file once per
+installed RMW and transport and prints a comparison table.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+# Sequence numbers ride on one stick axis, scaled into cmd_vel.linear.x.
+SEQUENCE_SLOTS = 999
+NODE_PROCESS = "pb_teleop_twist_joy_node"
+
+FASTDDS_PROFILE = """<?xml version="1.0" encoding="UTF-8"?>
+<profiles xmlns="http://www.eprosima.com/XMLSchemas/fastRTPS_Profiles">
+  <transport_descriptors>
+    <transport_descriptor>
+      <transport_id>benchmark_transport</transport_id>
+      {descriptor}
+    </transport_descriptor>
+  </transport_descriptors>
+  <participant profile_name="benchmark" is_default_profile="true">
+    <rtps>
+      <userTransports>
+        <transport_id>benchmark_transport</transport_id>
+      </userTransports>
+      <useBuiltinTransports>false</useBuiltinTransports>
+    </rtps>
+  </participant>
+</profiles>
+"""
+
+FASTDDS_DESCRIPTORS = {
+    "udp_loopback": "<type>UDPv4</type>"
+    "<interfaceWhiteList><address>127.0.0.1</address></interfaceWhiteList>",
+    "shm": "<type>SHM</type>",
+}
+
+CYCLONEDDS_LOOPBACK = (
+    "<CycloneDDS><Domain>"
+    '<General><Interfaces><NetworkInterface name="lo"/></Interfaces>'
+    "<AllowMulticast>false</AllowMulticast></General>"
+    '<Discovery><Peers><Peer address="localhost"/></Peers>'
+    "<ParticipantIndex>auto</ParticipantIndex>"
+    "<MaxAutoParticipantIndex>32</MaxAutoParticipantIndex></Discovery>"
+    "</Domain></CycloneDDS>"
+)
+
+TRANSPORTS = ["default", "udp_loopback", "shm"]
+
+
+def process_cpu_ticks(pattern):
+    ticks = 0
+    for pid in os.listdir("/proc"):
+        if not pid.isdigit():
+            continue
+        try:
+            with open(f"/proc/{pid}/cmdline", "rb") as cmdline:
+                if pattern.encode() not in cmdline.read():
+                    continue
+            with open(f"/proc/{pid}/stat") as stat:
+                # Fields after the parenthesized command name, utime and stime.
+                fields = stat.read().rsplit(")", 1)[1].split()
+            ticks += int(fields[11]) + int(fields[12])
+        except OSError:
+            continue
+    return ticks
+
+
+def percentile(sorted_values, fraction):
+    if not sorted_values:
+        return float("nan")
+    index = min(int(fraction * len(sorted_values)), len(sorted_values) - 1)
+    return sorted_values[index]
+
+
+def run_probe(args):
+    import rclpy
+    from example_interfaces.msg import UInt8
+    from geometry_msgs.msg import Twist
+    from rclpy.node import Node
+    from sensor_msgs.msg import JointState, Joy
+
+    class BenchmarkProbe(Node):
+        def __init__(self):
+            super().__init__("teleop_benchmark_probe")
+            self.joy_pub = self.create_publisher(Joy, "joy", 10)
+            self.create_subscription(Twist, "cmd_vel", self.on_cmd_vel, 10)
+            self.create_subscription(
+                JointState, "cmd_gimbal_joint", lambda _: self.count("joint"), 10
+            )
+            self.create_subscription(
+                UInt8, "cmd_shoot", lambda _: self.count("shoot"), 10
+            )
+            self.send_times = [0] * SEQUENCE_SLOTS
+            self.sequence = 0
+            self.sent = 0
+            self.received = {"cmd_vel": 0, "joint": 0, "shoot": 0}
+            self.latencies = []
+            self.start_ns = time.monotonic_ns() + int(args.warmup * 1e9)
+            self.stop_ns = self.start_ns + int(args.duration * 1e9)
+            self.start_ticks = None
+            self.create_timer(1.0 / args.rate, self.on_timer)
+
+        def measuring(self, now_ns):
+            return self.start_ns <= now_ns < self.stop_ns
+
+        def on_timer(self):
+            now_ns = time.monotonic_ns()
+            if now_ns >= self.stop_ns:
+                return
+            if self.start_ticks is None and now_ns >= self.start_ns:
+                self.start_ticks = process_cpu_ticks(NODE_PROCESS)
+            slot = self.sequence % SEQUENCE_SLOTS
+            self.sequence += 1
+            joy = Joy()
+            joy.header.stamp = self.get_clock().now().to_msg()
+            joy.axes = [0.0] * 8
+            joy.axes[args.sequence_axis] = (slot + 1) / 1000.0
+            joy.buttons = [0] * 12
+            joy.buttons[args.enable_button] = 1
+            self.send_times[slot] = now_ns
+            if self.measuring(now_ns):
+                self.sent += 1
+            self.joy_pub.publish(joy)
+
+        def on_cmd_vel(self, msg):
+            now_ns = time.monotonic_ns()
+            slot = round(msg.linear.x / args.sequence_scale * 1000.0) - 1
+            if not 0 <= slot < SEQUENCE_SLOTS:
+                return
+            sent_ns = self.send_times[slot]
+            if self.measuring(sent_ns):
+                self.received["cmd_vel"] += 1
+                self.latencies.append((now_ns - sent_ns) * 1e-3)
+
+        def count(self, topic):
+            if self.measuring(time.monotonic_ns() - int(args.drain * 1e9)):
+                self.received[topic] += 1
+
+    rclpy.init()
+    probe = BenchmarkProbe()
+    end_ns = probe.stop_ns + int(args.drain * 1e9)
+    while rclpy.ok() and time.monotonic_ns() < end_ns:
+        rclpy.spin_once(probe, timeout_sec=0.01)
+    stop_ticks = process_cpu_ticks(NODE_PROCESS)
+
+    latencies = sorted(probe.latencies)
+    sent = max(probe.sent, 1)
+    cpu = float("nan")
+    if probe.start_ticks is not None:
+        ticks = stop_ticks - probe.start_ticks
+        cpu = 100.0 * ticks / os.sysconf("SC_CLK_TCK") / (args.duration + args.drain)
+    result = {
+        "sent": probe.sent,
+        "rate_hz": probe.sent / args.duration,
+        "p50_us": percentile(latencies, 0.5),
+        "p90_us": percentile(latencies, 0.9),
+        "p99_us": percentile(latencies, 0.99),
+        "max_us": latencies[-1] if latencies else float("nan"),
+        "node_cpu_percent": cpu,
+        "drop_percent": {
+            topic: 100.0 * max(sent - count, 0) / sent
+            for topic, count in probe.received.items()
+        },
+    }
+    with open(args.result_file, "w") as result_file:
+        json.dump(result, result_file)
+    probe.destroy_node()
+    rclpy.try_shutdown()
+
+
+def installed_rmws():
+    from ament_index_python.resources import get_resources
+
+    return sorted(
+        name for name in get_resources("rmw_typesupport") if name.startswith("rmw_")
+    )
+
+
+def transport_env(rmw, transport, directory):
+    """Environment selecting `transport` for `rmw`, None when not supported."""
+    env = {"RMW_IMPLEMENTATION": rmw}
+    if transport == "default":
+        return env
+    if "fastrtps" in rmw and transport in FASTDDS_DESCRIPTORS:
+        path = os.path.join(directory, f"{transport}.xml")
+        with open(path, "w") as profile:
+            profile.write(
+                FASTDDS_PROFILE.format(descriptor=FASTDDS_DESCRIPTORS[transport])
+            )
+        env["FASTRTPS_DEFAULT_PROFILES_FILE"] = path
+        return env
+    if "cyclonedds" in rmw and transport == "udp_loopback":
+        env["CYCLONEDDS_URI"] = CYCLONEDDS_LOOPBACK
+        return env
+    # Cyclone DDS shared memory needs a running iceoryx RouDi, left out.
+    return None
+
+
+def run_matrix(args):
+    rmws = args.rmw or installed_rmws()
+    rows = []
+    with tempfile.TemporaryDirectory() as directory:
+        for rmw in rmws:
+            for transport in args.transport or TRANSPORTS:
+                transport_vars = transport_env(rmw, transport, directory)
+                if transport_vars is None:
+                    continue
+                env = dict(os.environ)
+                env.update(transport_vars)
+                env["ROS_DOMAIN_ID"] = str(args.domain_id)
+                result_path = os.path.join(directory, f"{rmw}_{transport}.json")
+                command = [
+                    "ros2",
+                    "launch",
+                    "pb_teleop_twist_joy",
+                    "benchmark_launch.py",
+                    f"result_file:={result_path}",
+                    f"rate:={args.rate}",
+                    f"duration:={args.duration}",
+                ]
+                print(f"Running {rmw} over {transport} ...", file=sys.stderr)
+                try:
+                    subprocess.run(
+                        command,
+                        env=env,
+                        stdout=subprocess.DEVNULL,
+                        stderr=subprocess.DEVNULL,
+                        timeout=args.duration + 60.0,
+                    )
+                    with open(result_path) as result_file:
+                        rows.append((rmw, transport, json.load(result_file)))
+                except (OSError, ValueError, subprocess.TimeoutExpired) as ex:
+                    print(f"  failed: {ex}", file=sys.stderr)
+
+    print(
+        "| RMW | transport | rate (Hz) | p50 (us) | p90 (us) | p99 (us) | max (us) "
+        "| node CPU (%) | drop cmd_vel / joint / shoot (%) |"
+    )
+    print("|---|---|---|---|---|---|---|---|---|")
+    for rmw, transport, result in rows:
+        drops = result["drop_percent"]
+        print(
+            f"| {rmw} | {transport} | {result['rate_hz']:.0f} "
+            f"| {result['p50_us']:.0f} | {result['p90_us']:.0f} "
+            f"| {result['p99_us']:.0f} | {result['max_us']:.0f} "
+            f"| {result['node_cpu_percent']:.1f} "
+            f"| {drops['cmd_vel']:.2f} / {drops['joint']:.2f} / {drops['shoot']:.2f} |"
+        )
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    matrix = commands.add_parser("matrix", help="benchmark every RMW and transport")
+    matrix.add_argument("--rmw", action="append", help="RMW to run, default all")
+    matrix.add_argument(
+        "--transport", action="append", choices=TRANSPORTS, help="default all"
+    )
+    matrix.add_argument("--rate", type=float, default=200.0)
+    matrix.add_argument("--duration", type=float, default=10.0)
+    matrix.add_argument("--domain-id", type=int, default=42)
+
+    probe = commands.add_parser("probe", help="drive and measure a running node")
+    probe.add_argument("--result-file", required=True)
+    probe.add_argument("--rate", type=float, default=200.0)
+    probe.add_argument("--duration", type=float, default=10.0)
+    probe.add_argument("--warmup", type=float, default=2.0)
+    probe.add_argument("--drain", type=float, default=0.5)
+    # Must match the node configuration, defaults are those of xbox.config.yaml.
+    probe.add_argument("--sequence-axis", type=int, default=1)
+    probe.add_argument("--sequence-scale", type=float, default=2.5)
+    probe.add_argument("--enable-button", type=int, default=4)
+
+    # Launch appends --ros-args to the probe command line.
+    args, _ = parser.parse_known_args()
+    if args.command == "probe":
+        run_probe(args)
+    else:
+        run_matrix(args)
+
+
+if __name__ == "__main__":
+    main()
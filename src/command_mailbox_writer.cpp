@@ -0,0 +1,90 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pb_teleop_twist_joy/command_mailbox_writer.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace pb_teleop_twist_joy
+{
+
+static_assert(
+  sizeof(pb_teleop_command_t) % sizeof(uint64_t) == 0,
+  "The mailbox command must consist of 8 byte words.");
+
+CommandMailboxWriter::~CommandMailboxWriter()
+{
+  if (mailbox_ != nullptr) {
+    munmap(mailbox_, sizeof(pb_teleop_mailbox_t));
+  }
+}
+
+bool CommandMailboxWriter::open(const std::string & name, std::string * error)
+{
+  int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+  if (fd < 0) {
+    *error = "shm_open " + name + ": " + std::strerror(errno);
+    return false;
+  }
+  if (ftruncate(fd, sizeof(pb_teleop_mailbox_t)) != 0) {
+    *error = "ftruncate " + name + ": " + std::strerror(errno);
+    close(fd);
+    return false;
+  }
+  void * address =
+    mmap(nullptr, sizeof(pb_teleop_mailbox_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    *error = "mmap " + name + ": " + std::strerror(errno);
+    return false;
+  }
+  mailbox_ = static_cast<pb_teleop_mailbox_t *>(address);
+
+  // A segment left by an earlier run keeps its sequence, so readers waiting for
+  // a change do not miss the first new command.
+  command_.sequence = mailbox_->magic == PB_TELEOP_MAILBOX_MAGIC ? mailbox_->command.sequence : 0;
+  if (mailbox_->seqlock & 1u) {
+    // The earlier writer died in the middle of a write.
+    __atomic_store_n(&mailbox_->seqlock, mailbox_->seqlock + 1, __ATOMIC_RELEASE);
+  }
+  mailbox_->version = PB_TELEOP_MAILBOX_VERSION;
+  __atomic_store_n(&mailbox_->magic, PB_TELEOP_MAILBOX_MAGIC, __ATOMIC_RELEASE);
+  return true;
+}
+
+void CommandMailboxWriter::write(
+  const TeleopCommand & command, const std::vector<double> & joints, int64_t stamp_ns)
+{
+  command_.stamp_ns = stamp_ns;
+  ++command_.sequence;
+  for (size_t i = 0; i < 3; ++i) {
+    command_.linear[i] = command.chassis[LINEAR_X + i];
+    command_.angular[i] = command.chassis[ANGULAR_X + i];
+  }
+  command_.shoot = command.shoot;
+  command_.profile = static_cast<int32_t>(command.profile);
+  command_.num_joints =
+    static_cast<uint32_t>(std::min(joints.size(), size_t{PB_TELEOP_MAILBOX_MAX_JOINTS}));
+  std::copy_n(joints.begin(), command_.num_joints, command_.joints);
+  pb_teleop_mailbox_write(mailbox_, &command_);
+}
+
+}  // namespace pb_teleop_twist_joy
@@ -0,0 +1,101 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pb_teleop_twist_joy/costmap_cache.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pb_teleop_twist_joy
+{
+
+void CostmapCache::setMap(
+  double resolution, double origin_x, double origin_y, uint32_t width, uint32_t height,
+  const std::vector<int8_t> & data)
+{
+  if (data.size() != static_cast<size_t>(width) * height || resolution <= 0.0) {
+    // Also drops the size, so no update lands on a map that is not there.
+    width_ = 0;
+    height_ = 0;
+    cells_.clear();
+    return;
+  }
+  resolution_ = resolution;
+  origin_x_ = origin_x;
+  origin_y_ = origin_y;
+  width_ = width;
+  height_ = height;
+  cells_ = data;
+}
+
+bool CostmapCache::update(
+  uint32_t x, uint32_t y, uint32_t width, uint32_t height, const std::vector<int8_t> & data)
+{
+  if (
+    data.size() != static_cast<size_t>(width) * height || int64_t{x} + width > width_ ||
+    int64_t{y} + height > height_) {
+    return false;
+  }
+  for (uint32_t row = 0; row < height; ++row) {
+    std::copy_n(data.data() + size_t{row} * width, width, cells_.data() + (y + row) * width_ + x);
+  }
+  return true;
+}
+
+bool CostmapCache::snapToFree(
+  double * x, double * y, int occupied_threshold, double max_distance, bool allow_unknown) const
+{
+  int64_t cell_x = static_cast<int64_t>(std::floor((*x - origin_x_) / resolution_));
+  int64_t cell_y = static_cast<int64_t>(std::floor((*y - origin_y_) / resolution_));
+  if (empty() || cell_x < 0 || cell_y < 0 || cell_x >= width_ || cell_y >= height_) {
+    return true;
+  }
+  if (isFree(cells_[cell_y * width_ + cell_x], occupied_threshold, allow_unknown)) {
+    return true;
+  }
+
+  // Grow square rings around the goal cell. A ring at radius r holds no cell
+  // closer than r, so the search ends once r passes the best distance so far.
+  int64_t max_radius = static_cast<int64_t>(max_distance / resolution_);
+  int64_t best_distance_sq = max_radius * max_radius + 1;
+  int64_t best_x = -1;
+  int64_t best_y = -1;
+  for (int64_t radius = 1; radius <= max_radius && radius * radius < best_distance_sq; ++radius) {
+    for (int64_t dy = -radius; dy <= radius; ++dy) {
+      // Only the ring edges: both columns on the top and bottom rows, else two.
+      int64_t step = (dy == -radius || dy == radius) ? 1 : 2 * radius;
+      for (int64_t dx = -radius; dx <= radius; dx += step) {
+        int64_t nx = cell_x + dx;
+        int64_t ny = cell_y + dy;
+        int64_t distance_sq = dx * dx + dy * dy;
+        if (
+          nx < 0 || ny < 0 || nx >= width_ || ny >= height_ || distance_sq >= best_distance_sq ||
+          !isFree(cells_[ny * width_ + nx], occupied_threshold, allow_unknown)) {
+          continue;
+        }
+        best_distance_sq = distance_sq;
+        best_x = nx;
+        best_y = ny;
+      }
+    }
+  }
+  if (best_x < 0) {
+    return false;
+  }
+  *x = origin_x_ + (static_cast<double>(best_x) + 0.5) * resolution_;
+  *y = origin_y_ + (static_cast<double>(best_y) + 0.5) * resolution_;
+  return true;
+}
+
+}  // namespace pb_teleop_twist_joy
@@ -0,0 +1,92 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pb_teleop_twist_joy/duration_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace pb_teleop_twist_joy
+{
+
+constexpr size_t DurationHistogram::SUB_BUCKETS;
+constexpr size_t DurationHistogram::NUM_BUCKETS;
+
+DurationHistogram::DurationHistogram() { reset(); }
+
+void DurationHistogram::reset()
+{
+  std::fill(buckets_, buckets_ + NUM_BUCKETS, 0);
+  count_ = 0;
+  sum_ = 0.0;
+  min_ = std::numeric_limits<int64_t>::max();
+  max_ = 0;
+}
+
+size_t DurationHistogram::bucketOf(uint64_t value)
+{
+  if (value < SUB_BUCKETS) {
+    return static_cast<size_t>(value);
+  }
+  // Octave from the highest set bit, then the next three bits pick the sub-bucket.
+  size_t octave = 63 - static_cast<size_t>(__builtin_clzll(value));
+  size_t sub = static_cast<size_t>(value >> (octave - 3)) & (SUB_BUCKETS - 1);
+  return (octave - 2) * SUB_BUCKETS + sub;
+}
+
+uint64_t DurationHistogram::bucketUpperBound(size_t bucket)
+{
+  if (bucket < SUB_BUCKETS) {
+    return bucket;
+  }
+  size_t octave = bucket / SUB_BUCKETS + 2;
+  uint64_t sub = bucket % SUB_BUCKETS;
+  uint64_t lower = (SUB_BUCKETS + sub) << (octave - 3);
+  return lower + (uint64_t{1} << (octave - 3)) - 1;
+}
+
+void DurationHistogram::record(int64_t duration_ns)
+{
+  uint64_t value = duration_ns > 0 ? static_cast<uint64_t>(duration_ns) : 0;
+  ++buckets_[bucketOf(value)];
+  ++count_;
+  sum_ += static_cast<double>(value);
+  min_ = std::min(min_, static_cast<int64_t>(value));
+  max_ = std::max(max_, static_cast<int64_t>(value));
+}
+
+double DurationHistogram::mean() const
+{
+  return count_ == 0 ? 0.0 : sum_ / static_cast<double>(count_);
+}
+
+int64_t DurationHistogram::percentile(double q) const
+{
+  if (count_ == 0) {
+    return 0;
+  }
+  uint64_t rank = static_cast<uint64_t>(std::ceil(std::min(std::max(q, 0.0), 1.0) * count_));
+  rank = std::max<uint64_t>(rank, 1);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < NUM_BUCKETS; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return std::min(static_cast<int64_t>(bucketUpperBound(i)), max_);
+    }
+  }
+  return max_;
+}
+
+}  // namespace pb_teleop_twist_joy
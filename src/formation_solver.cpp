@@ -0,0 +1,150 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pb_teleop_twist_joy/formation_solver.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+double limit(double value, double max_abs) { return std::min(std::max(value, -max_abs), max_abs); }
+}  // namespace
+
+void FormationSolver::configure(
+  const std::vector<FormationSlot> & slots, double position_gain, double yaw_gain,
+  double max_linear_correction, double max_angular_correction)
+{
+  const size_t n = slots.size();
+  position_gain_ = position_gain;
+  yaw_gain_ = yaw_gain;
+  max_linear_correction_ = max_linear_correction;
+  max_angular_correction_ = max_angular_correction;
+
+  offset_x_.resize(n);
+  offset_y_.resize(n);
+  offset_yaw_.resize(n);
+  for (size_t i = 0; i < n; ++i) {
+    offset_x_[i] = slots[i].x;
+    offset_y_[i] = slots[i].y;
+    offset_yaw_[i] = slots[i].yaw;
+  }
+  pose_x_.assign(n, 0.0);
+  pose_y_.assign(n, 0.0);
+  pose_yaw_.assign(n, 0.0);
+  pose_cos_.assign(n, 1.0);
+  pose_sin_.assign(n, 0.0);
+  pose_stamp_ns_.assign(n, 0);
+  fresh_.assign(n, 0);
+  cmd_x_.assign(n, 0.0);
+  cmd_y_.assign(n, 0.0);
+  cmd_yaw_.assign(n, 0.0);
+  anchored_ = false;
+}
+
+void FormationSolver::setPose(size_t robot, double x, double y, double yaw, int64_t stamp_ns)
+{
+  pose_x_[robot] = x;
+  pose_y_[robot] = y;
+  pose_yaw_[robot] = yaw;
+  pose_cos_[robot] = std::cos(yaw);
+  pose_sin_[robot] = std::sin(yaw);
+  pose_stamp_ns_[robot] = stamp_ns;
+}
+
+bool FormationSolver::anchor(const uint8_t * fresh)
+{
+  // Place the center where the robots currently are: the circular mean of the
+  // headings, then the mean of the positions minus the rotated offsets.
+  const size_t n = size();
+  double sum_cos = 0.0;
+  double sum_sin = 0.0;
+  size_t count = 0;
+  for (size_t i = 0; i < n; ++i) {
+    if (fresh[i]) {
+      sum_cos += std::cos(pose_yaw_[i] - offset_yaw_[i]);
+      sum_sin += std::sin(pose_yaw_[i] - offset_yaw_[i]);
+      ++count;
+    }
+  }
+  if (count == 0) {
+    return false;
+  }
+  center_yaw_ = std::atan2(sum_sin, sum_cos);
+  const double c = std::cos(center_yaw_);
+  const double s = std::sin(center_yaw_);
+  double sum_x = 0.0;
+  double sum_y = 0.0;
+  for (size_t i = 0; i < n; ++i) {
+    if (fresh[i]) {
+      sum_x += pose_x_[i] - (c * offset_x_[i] - s * offset_y_[i]);
+      sum_y += pose_y_[i] - (s * offset_x_[i] + c * offset_y_[i]);
+    }
+  }
+  center_x_ = sum_x / static_cast<double>(count);
+  center_y_ = sum_y / static_cast<double>(count);
+  anchored_ = true;
+  return true;
+}
+
+void FormationSolver::solve(
+  double linear_x, double linear_y, double angular_z, double dt, int64_t now_ns,
+  int64_t pose_timeout_ns)
+{
+  const size_t n = size();
+  for (size_t i = 0; i < n; ++i) {
+    fresh_[i] = (pose_stamp_ns_[i] != 0 && now_ns - pose_stamp_ns_[i] <= pose_timeout_ns) ? 1 : 0;
+  }
+  if (!anchored_ && !anchor(fresh_.data())) {
+    std::fill(cmd_x_.begin(), cmd_x_.end(), 0.0);
+    std::fill(cmd_y_.begin(), cmd_y_.end(), 0.0);
+    std::fill(cmd_yaw_.begin(), cmd_yaw_.end(), 0.0);
+    return;
+  }
+
+  // Group velocity in the fixed frame.
+  const double c = std::cos(center_yaw_);
+  const double s = std::sin(center_yaw_);
+  const double group_x = c * linear_x - s * linear_y;
+  const double group_y = s * linear_x + c * linear_y;
+
+  for (size_t i = 0; i < n; ++i) {
+    // Slot offset in the fixed frame, and the slot's velocity on the rigid body.
+    const double offset_x = c * offset_x_[i] - s * offset_y_[i];
+    const double offset_y = s * offset_x_[i] + c * offset_y_[i];
+    const double correction_x =
+      limit(position_gain_ * (center_x_ + offset_x - pose_x_[i]), max_linear_correction_);
+    const double correction_y =
+      limit(position_gain_ * (center_y_ + offset_y - pose_y_[i]), max_linear_correction_);
+    const double velocity_x = group_x - angular_z * offset_y + correction_x;
+    const double velocity_y = group_y + angular_z * offset_x + correction_y;
+    const double yaw_error =
+      std::remainder(center_yaw_ + offset_yaw_[i] - pose_yaw_[i], 2.0 * M_PI);
+
+    // Into the robot's base frame, zero for robots without a recent pose.
+    const double active = fresh_[i] ? 1.0 : 0.0;
+    cmd_x_[i] = active * (pose_cos_[i] * velocity_x + pose_sin_[i] * velocity_y);
+    cmd_y_[i] = active * (pose_cos_[i] * velocity_y - pose_sin_[i] * velocity_x);
+    cmd_yaw_[i] = active * (angular_z + limit(yaw_gain_ * yaw_error, max_angular_correction_));
+  }
+
+  center_x_ += group_x * dt;
+  center_y_ += group_y * dt;
+  center_yaw_ = std::remainder(center_yaw_ + angular_z * dt, 2.0 * M_PI);
+}
+
+}  // namespace pb_teleop_twist_joy
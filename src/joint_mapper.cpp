@@ -0,0 +1,99 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pb_teleop_twist_joy/joint_mapper.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+bool JointMapper::configure(const std::vector<JointBinding> & bindings)
+{
+  const size_t n = bindings.size();
+  std::vector<bool> taken(n, false);
+  bool valid_indices = true;
+  for (const auto & binding : bindings) {
+    if (binding.output_index >= n || taken[binding.output_index]) {
+      valid_indices = false;
+      break;
+    }
+    taken[binding.output_index] = true;
+  }
+
+  axis_.resize(n);
+  scale_.resize(n);
+  scale_turbo_.resize(n);
+  integrate_.resize(n);
+  min_.resize(n);
+  max_.resize(n);
+  output_index_.resize(n);
+  names_.resize(n);
+  output_.assign(n, 0.0);
+
+  for (size_t i = 0; i < n; ++i) {
+    const JointBinding & binding = bindings[i];
+    axis_[i] = binding.axis;
+    scale_[i] = binding.scale;
+    scale_turbo_[i] = binding.scale_turbo;
+    integrate_[i] = binding.mode == JointMode::RATE ? 1 : 0;
+    min_[i] = binding.min;
+    max_[i] = binding.max;
+    output_index_[i] = valid_indices ? binding.output_index : i;
+    names_[output_index_[i]] = binding.name;
+    // Start inside the limits when zero is not reachable.
+    output_[output_index_[i]] = initialJointSetpoint(binding.min, binding.max);
+  }
+  return valid_indices;
+}
+
+void JointMapper::update(const JoySnapshot & joy, bool turbo, double dt)
+{
+  const double * scale = turbo ? scale_turbo_.data() : scale_.data();
+  const size_t n = axis_.size();
+  for (size_t i = 0; i < n; ++i) {
+    double & setpoint = output_[output_index_[i]];
+    setpoint =
+      stepJoint(setpoint, joy.axis(axis_[i]) * scale[i], dt, integrate_[i] != 0, min_[i], max_[i]);
+  }
+}
+
+void JointMapper::predict(
+  const std::vector<double> & start, const JoySnapshot & joy, bool turbo, double step,
+  size_t num_steps, double * positions, double * velocities) const
+{
+  const double * scale = turbo ? scale_turbo_.data() : scale_.data();
+  const size_t n = axis_.size();
+  for (size_t i = 0; i < n; ++i) {
+    const size_t column = output_index_[i];
+    const double command = joy.axis(axis_[i]) * scale[i];
+    double setpoint = start[column];
+    for (size_t k = 0; k < num_steps; ++k) {
+      double next = stepJoint(setpoint, command, step, integrate_[i] != 0, min_[i], max_[i]);
+      positions[k * n + column] = next;
+      velocities[k * n + column] = step > 0.0 ? (next - setpoint) / step : 0.0;
+      setpoint = next;
+    }
+  }
+}
+
+void JointMapper::restore(const std::vector<double> & positions)
+{
+  if (positions.size() != output_.size()) {
+    return;
+  }
+  for (size_t i = 0; i < axis_.size(); ++i) {
+    output_[output_index_[i]] = limitSetpoint(positions[output_index_[i]], min_[i], max_[i]);
+  }
+}
+
+}  // namespace pb_teleop_twist_joy
@@ -0,0 +1,171 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pb_teleop_twist_joy/joy_cdr_decoder.hpp"
+
+#include <cstring>
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+// Encapsulation header in front of the payload, see the DDS-XTypes spec.
+constexpr size_t ENCAPSULATION_SIZE = 4;
+constexpr uint8_t CDR_BE = 0x00;
+constexpr uint8_t CDR_LE = 0x01;
+
+class CdrReader
+{
+public:
+  CdrReader(const uint8_t * data, size_t size, bool swap)
+  : data_(data), size_(size), offset_(ENCAPSULATION_SIZE), swap_(swap)
+  {
+  }
+
+  // Alignment is relative to the end of the encapsulation header.
+  bool align4()
+  {
+    offset_ = ENCAPSULATION_SIZE + ((offset_ - ENCAPSULATION_SIZE + 3) & ~size_t{3});
+    return offset_ <= size_;
+  }
+
+  bool read32(uint32_t * value)
+  {
+    if (!align4() || size_ - offset_ < 4) {
+      return false;
+    }
+    *value = load32(offset_);
+    offset_ += 4;
+    return true;
+  }
+
+  bool skip(size_t bytes)
+  {
+    if (size_ - offset_ < bytes) {
+      return false;
+    }
+    offset_ += bytes;
+    return true;
+  }
+
+  // Start of a sequence of `count` 4 byte elements, bounds checked.
+  bool sequence32(uint32_t * count, size_t * begin)
+  {
+    if (!read32(count) || (size_ - offset_) / 4 < *count) {
+      return false;
+    }
+    *begin = offset_;
+    offset_ += size_t{*count} * 4;
+    return true;
+  }
+
+  uint32_t load32(size_t at) const
+  {
+    uint32_t value;
+    std::memcpy(&value, data_ + at, sizeof(value));
+    return swap_ ? __builtin_bswap32(value) : value;
+  }
+
+private:
+  const uint8_t * data_;
+  size_t size_;
+  size_t offset_;
+  bool swap_;
+};
+
+bool hostIsLittleEndian()
+{
+  const uint16_t probe = 1;
+  uint8_t first;
+  std::memcpy(&first, &probe, 1);
+  return first == 1;
+}
+}  // namespace
+
+JoyCdrDecoder::JoyCdrDecoder() : num_bound_axes_(0), num_bound_buttons_(0) {}
+
+void JoyCdrDecoder::bind(const std::vector<int64_t> & axes, const std::vector<int64_t> & buttons)
+{
+  num_bound_axes_ = 0;
+  for (int64_t index : axes) {
+    if (index >= 0 && index < int64_t{JOY_MAX_AXES}) {
+      bound_axes_[num_bound_axes_++] = static_cast<uint8_t>(index);
+    }
+    if (num_bound_axes_ == JOY_MAX_AXES) {
+      break;
+    }
+  }
+  num_bound_buttons_ = 0;
+  for (int64_t index : buttons) {
+    if (index >= 0 && index < int64_t{JOY_MAX_BUTTONS}) {
+      bound_buttons_[num_bound_buttons_++] = static_cast<uint8_t>(index);
+    }
+    if (num_bound_buttons_ == JOY_MAX_BUTTONS) {
+      break;
+    }
+  }
+}
+
+bool JoyCdrDecoder::decode(const uint8_t * data, size_t size, JoySnapshot * snapshot) const
+{
+  if (size < ENCAPSULATION_SIZE || data[0] != 0x00 || (data[1] != CDR_BE && data[1] != CDR_LE)) {
+    return false;
+  }
+  static const bool little_endian_host = hostIsLittleEndian();
+  CdrReader reader(data, size, (data[1] == CDR_LE) != little_endian_host);
+
+  // std_msgs/Header: stamp.sec, stamp.nanosec, frame_id.
+  uint32_t sec;
+  uint32_t nanosec;
+  uint32_t frame_id_size;
+  if (!reader.read32(&sec) || !reader.read32(&nanosec) || !reader.read32(&frame_id_size)) {
+    return false;
+  }
+  if (!reader.skip(frame_id_size)) {
+    return false;
+  }
+
+  uint32_t num_axes;
+  size_t axes_begin;
+  uint32_t num_buttons;
+  size_t buttons_begin;
+  if (
+    !reader.sequence32(&num_axes, &axes_begin) ||
+    !reader.sequence32(&num_buttons, &buttons_begin)) {
+    return false;
+  }
+
+  snapshot->stamp_ns =
+    static_cast<int64_t>(static_cast<int32_t>(sec)) * 1000000000LL + static_cast<int64_t>(nanosec);
+  snapshot->num_axes = num_axes;
+  snapshot->num_buttons = num_buttons;
+  for (size_t i = 0; i < num_bound_axes_; ++i) {
+    uint8_t index = bound_axes_[i];
+    if (index < num_axes) {
+      uint32_t bits = reader.load32(axes_begin + size_t{index} * 4);
+      std::memcpy(&snapshot->axes[index], &bits, sizeof(bits));
+    }
+  }
+  for (size_t i = 0; i < num_bound_buttons_; ++i) {
+    uint8_t index = bound_buttons_[i];
+    if (index < num_buttons) {
+      uint32_t bits = reader.load32(buttons_begin + size_t{index} * 4);
+      std::memcpy(&snapshot->buttons[index], &bits, sizeof(bits));
+    }
+  }
+  return true;
+}
+
+}  // namespace pb_teleop_twist_joy
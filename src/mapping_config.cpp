@@ -0,0 +1,117 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pb_teleop_twist_joy/mapping_config.hpp"
+
+#include <utility>
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+template <typename T>
+using Defaults = std::vector<std::pair<std::string, T>>;
+
+void loadIntMap(
+  ParameterSource * parameters, const std::string & name, const Defaults<int64_t> & defaults,
+  std::map<std::string, int64_t> * values)
+{
+  for (const auto & entry : defaults) {
+    (*values)[entry.first] = parameters->getInt(name + "." + entry.first, entry.second);
+  }
+}
+
+void loadDoubleMap(
+  ParameterSource * parameters, const std::string & name, const Defaults<double> & defaults,
+  std::map<std::string, double> * values)
+{
+  for (const auto & entry : defaults) {
+    (*values)[entry.first] = parameters->getDouble(name + "." + entry.first, entry.second);
+  }
+}
+}  // namespace
+
+MappingConfig loadMappingConfig(ParameterSource * parameters, const std::string & prefix)
+{
+  MappingConfig config;
+  config.require_enable_button =
+    parameters->getBool(prefix + "require_enable_button", config.require_enable_button);
+  config.enable_button = parameters->getInt(prefix + "enable_button", config.enable_button);
+  config.enable_turbo_button =
+    parameters->getInt(prefix + "enable_turbo_button", config.enable_turbo_button);
+  config.inverted_reverse = parameters->getBool(prefix + "inverted_reverse", false);
+  config.max_integration_dt =
+    parameters->getDouble(prefix + "max_integration_dt", config.max_integration_dt);
+
+  loadIntMap(
+    parameters, prefix + "axis_chassis", {{"x", 5L}, {"y", -1L}, {"yaw", -1L}},
+    &config.axis_chassis);
+  loadIntMap(
+    parameters, prefix + "axis_gimbal", {{"yaw", 3L}, {"pitch", 4L}, {"roll", -1L}, {"shoot", 5L}},
+    &config.axis_gimbal);
+  loadDoubleMap(
+    parameters, prefix + "scale_chassis", {{"x", 0.5}, {"y", 0.0}, {"yaw", 0.0}},
+    &config.scale_chassis["normal"]);
+  loadDoubleMap(
+    parameters, prefix + "scale_chassis_turbo", {{"x", 1.0}, {"y", 0.0}, {"yaw", 0.0}},
+    &config.scale_chassis["turbo"]);
+  loadDoubleMap(
+    parameters, prefix + "scale_gimbal",
+    {{"yaw", 0.5}, {"pitch", 0.0}, {"roll", 0.0}, {"shoot", 1.0}}, &config.scale_gimbal["normal"]);
+  loadDoubleMap(
+    parameters, prefix + "scale_gimbal_turbo",
+    {{"yaw", 1.0}, {"pitch", 0.0}, {"roll", 0.0}, {"shoot", 1.0}}, &config.scale_gimbal["turbo"]);
+
+  std::vector<std::string> joint_names =
+    parameters->getStringArray(prefix + "joints", std::vector<std::string>());
+  if (joint_names.empty()) {
+    // Legacy two joint gimbal driven by axis_gimbal and scale_gimbal.
+    const char * fields[] = {"pitch", "yaw"};
+    const char * names[] = {"gimbal_pitch_joint", "gimbal_yaw_joint"};
+    for (size_t i = 0; i < 2; ++i) {
+      JointBinding binding;
+      binding.name = names[i];
+      binding.axis = config.axis_gimbal[fields[i]];
+      binding.scale = config.scale_gimbal["normal"][fields[i]];
+      binding.scale_turbo = config.scale_gimbal["turbo"][fields[i]];
+      binding.output_index = i;
+      config.joints.push_back(binding);
+    }
+  }
+
+  for (size_t i = 0; i < joint_names.size(); ++i) {
+    const std::string joint_prefix = prefix + "joint." + joint_names[i] + ".";
+    JointBinding binding;
+    binding.name = joint_names[i];
+    binding.axis = parameters->getInt(joint_prefix + "axis", -1L);
+    binding.scale = parameters->getDouble(joint_prefix + "scale", 0.0);
+    binding.scale_turbo = parameters->getDouble(joint_prefix + "scale_turbo", binding.scale);
+    std::string mode = parameters->getString(joint_prefix + "mode", "rate");
+    if (mode == "position") {
+      binding.mode = JointMode::POSITION;
+    } else if (mode != "rate") {
+      config.warnings.push_back(
+        "Unknown mode '" + mode + "' for joint " + joint_names[i] + ", using rate.");
+    }
+    binding.min = parameters->getDouble(joint_prefix + "min", binding.min);
+    binding.max = parameters->getDouble(joint_prefix + "max", binding.max);
+    binding.output_index =
+      static_cast<size_t>(parameters->getInt(joint_prefix + "output_index", i));
+    config.joints.push_back(binding);
+  }
+  return config;
+}
+
+}  // namespace pb_teleop_twist_joy
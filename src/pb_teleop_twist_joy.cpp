@@ -14,13 +14,246 @@
 
 #include "pb_teleop_twist_joy/pb_teleop_twist_joy.hpp"
 
+#include <pthread.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
 #include <cinttypes>
+#include <cstring>
+#include <initializer_list>
+#include <set>
+#include <string>
+#include <vector>
 
 namespace pb_teleop_twist_joy
 {
 
+namespace
+{
+void addValue(diagnostic_msgs::msg::DiagnosticStatus * status, const char * key, double value)
+{
+  diagnostic_msgs::msg::KeyValue key_value;
+  key_value.key = key;
+  key_value.value = std::to_string(value);
+  status->values.push_back(key_value);
+}
+
+diagnostic_msgs::msg::DiagnosticStatus makeDurationStatus(
+  const std::string & name, const DurationHistogram & histogram, int64_t budget_ns,
+  uint64_t over_budget, double window)
+{
+  diagnostic_msgs::msg::DiagnosticStatus status;
+  status.name = name;
+  status.hardware_id = "pb_teleop_twist_joy";
+  addValue(&status, "count", static_cast<double>(histogram.count()));
+  addValue(
+    &status, "rate_hz", window > 0.0 ? static_cast<double>(histogram.count()) / window : 0.0);
+  addValue(&status, "mean_us", histogram.mean() * 1e-3);
+  addValue(&status, "p50_us", static_cast<double>(histogram.percentile(0.5)) * 1e-3);
+  addValue(&status, "p99_us", static_cast<double>(histogram.percentile(0.99)) * 1e-3);
+  addValue(&status, "max_us", static_cast<double>(histogram.max()) * 1e-3);
+  if (budget_ns > 0) {
+    addValue(&status, "budget_us", static_cast<double>(budget_ns) * 1e-3);
+    addValue(&status, "over_budget", static_cast<double>(over_budget));
+  }
+  if (budget_ns > 0 && histogram.percentile(0.99) > budget_ns) {
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+    status.message = "p99 over budget";
+  } else {
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+    status.message = "OK";
+  }
+  return status;
+}
+
+// Publish latency of each output over the last publisher health poll. Slow
+// publishes only count as backpressure while somebody is subscribed.
+diagnostic_msgs::msg::DiagnosticStatus makeBackpressureStatus(
+  const std::string & name, std::initializer_list<const PublisherHealth *> outputs)
+{
+  diagnostic_msgs::msg::DiagnosticStatus status;
+  status.name = name;
+  status.hardware_id = "pb_teleop_twist_joy";
+  status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+  status.message = "OK";
+  for (const PublisherHealth * health : outputs) {
+    const std::string & topic = health->topic();
+    addValue(
+      &status, (topic + "_subscriptions").c_str(),
+      static_cast<double>(health->subscriptionCount()));
+    addValue(
+      &status, (topic + "_publishes").c_str(), static_cast<double>(health->windowPublishes()));
+    addValue(
+      &status, (topic + "_slow_publishes").c_str(),
+      static_cast<double>(health->windowSlowPublishes()));
+    addValue(
+      &status, (topic + "_max_publish_ms").c_str(),
+      static_cast<double>(health->windowMaxPublishNs()) * 1e-6);
+    if (health->windowSlowPublishes() > 0 && health->subscriptionCount() > 0) {
+      status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+      status.message = "slow consumer";
+    }
+  }
+  return status;
+}
+
+int64_t steadyNowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+void toJoySnapshot(const sensor_msgs::msg::Joy & joy_msg, JoySnapshot * joy)
+{
+  joy->stamp_ns = rclcpp::Time(joy_msg.header.stamp).nanoseconds();
+  joy->num_axes = static_cast<uint32_t>(joy_msg.axes.size());
+  joy->num_buttons = static_cast<uint32_t>(joy_msg.buttons.size());
+  std::copy_n(joy_msg.axes.begin(), std::min(joy_msg.axes.size(), JOY_MAX_AXES), joy->axes);
+  std::copy_n(
+    joy_msg.buttons.begin(), std::min(joy_msg.buttons.size(), JOY_MAX_BUTTONS), joy->buttons);
+}
+
+// Pins the calling thread to `cpu`, negative leaves it unpinned.
+void pinCurrentThread(int64_t cpu, const rclcpp::Logger & logger)
+{
+  if (cpu < 0) {
+    return;
+  }
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET(static_cast<int>(cpu), &cpus);
+  int result = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+  if (result != 0) {
+    RCLCPP_WARN(
+      logger, "Could not pin a pipeline thread to CPU %" PRId64 ": %s", cpu, std::strerror(result));
+  }
+}
+
+diagnostic_msgs::msg::DiagnosticStatus makePerfStatus(
+  const std::string & name, PerfCounters & perf_counters)
+{
+  static const char * EVENT_NAMES[NUM_PERF_EVENTS] = {
+    "cycles", "instructions", "cache_misses", "branch_misses"};
+  diagnostic_msgs::msg::DiagnosticStatus status;
+  status.name = name;
+  status.hardware_id = "pb_teleop_twist_joy";
+  if (perf_counters.unavailable()) {
+    status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+    status.message = "unavailable: " + perf_counters.error();
+    return status;
+  }
+
+  PerfStageTotals totals[NUM_PERF_STAGES];
+  perf_counters.collect(totals);
+  for (size_t stage = 0; stage < NUM_PERF_STAGES; ++stage) {
+    const PerfStageTotals & stage_totals = totals[stage];
+    if (stage_totals.runs == 0) {
+      continue;
+    }
+    // Per-run averages, keyed "<stage>/<event>".
+    std::string prefix = std::string(perfStageName(static_cast<PerfStage>(stage))) + "/";
+    addValue(&status, (prefix + "runs").c_str(), static_cast<double>(stage_totals.runs));
+    for (size_t event = 0; event < NUM_PERF_EVENTS; ++event) {
+      if (stage_totals.counted[event]) {
+        addValue(
+          &status, (prefix + EVENT_NAMES[event]).c_str(),
+          static_cast<double>(stage_totals.values[event]) / static_cast<double>(stage_totals.runs));
+      }
+    }
+    if (stage_totals.values[PERF_CYCLES] > 0) {
+      addValue(
+        &status, (prefix + "ipc").c_str(),
+        static_cast<double>(stage_totals.values[PERF_INSTRUCTIONS]) /
+          static_cast<double>(stage_totals.values[PERF_CYCLES]));
+    }
+  }
+  status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+  status.message = "OK";
+  return status;
+}
+
+// Declares each mapping parameter on the node the first time it is read.
+class NodeParameterSource : public ParameterSource
+{
+public:
+  explicit NodeParameterSource(rclcpp::Node * node) : node_(node) {}
+
+  bool getBool(const std::string & name, bool default_value) override
+  {
+    return get(name, default_value);
+  }
+  int64_t getInt(const std::string & name, int64_t default_value) override
+  {
+    return get(name, default_value);
+  }
+  double getDouble(const std::string & name, double default_value) override
+  {
+    return get(name, default_value);
+  }
+  std::string getString(const std::string & name, const std::string & default_value) override
+  {
+    return get(name, default_value);
+  }
+  std::vector<std::string> getStringArray(
+    const std::string & name, const std::vector<std::string> & default_value) override
+  {
+    return get(name, default_value);
+  }
+
+private:
+  template <typename T>
+  T get(const std::string & name, const T & default_value)
+  {
+    if (!node_->has_parameter(name)) {
+      return node_->declare_parameter<T>(name, default_value);
+    }
+    return node_->get_parameter(name).get_value<T>();
+  }
+
+  rclcpp::Node * node_;
+};
+}  // namespace
+
 TeleopTwistJoyNode::TeleopTwistJoyNode(const rclcpp::NodeOptions & options)
-: Node("teleop_twist_joy_node", options)
+: Node("teleop_twist_joy_node", options),
+  rc_protocol_(RcProtocol::DBUS),
+  rc_timeout_ns_(0),
+  rc_stop_(false),
+  goal_snap_enable_(false),
+  goal_snap_occupied_threshold_(99),
+  goal_snap_max_distance_(0.0),
+  goal_snap_allow_unknown_(false),
+  sent_disable_msg_(false),
+  throttled_logger_(this->get_logger()),
+  last_input_time_ns_(0),
+  time_jumped_(false),
+  skip_unsubscribed_outputs_(false),
+  cmd_vel_health_("cmd_vel"),
+  joint_state_health_("cmd_gimbal_joint"),
+  shoot_health_("cmd_shoot"),
+  statistics_enable_(false),
+  callback_budget_ns_(0),
+  callback_over_budget_(0),
+  latency_budget_ns_(0),
+  input_latency_over_budget_(0),
+  last_latency_stamp_ns_(0),
+  shadow_enable_(false),
+  trajectory_enable_(false),
+  trajectory_period_ns_(0),
+  last_trajectory_time_ns_(0),
+  trajectory_step_(0.0),
+  trajectory_steps_(0),
+  formation_enable_(false),
+  formation_pose_timeout_ns_(0),
+  power_governor_enable_(false),
+  power_governor_min_scale_(1.0),
+  pipeline_enable_(false),
+  pipeline_stop_(false),
+  latest_joy_valid_(false),
+  phase_lock_stop_(false),
+  phase_lock_rescheduled_(false)
 {
   RCLCPP_INFO(this->get_logger(), "Starting Teleop Twist Joy");
   tf_buffer_ = std::make_shared<tf2_ros::Buffer>(this->get_clock());
@@ -28,124 +261,717 @@ TeleopTwistJoyNode::TeleopTwistJoyNode(const rclcpp::NodeOptions & options)
 
   this->declare_parameter<bool>("publish_stamped_twist", false);
   this->declare_parameter<std::string>("robot_base_frame", "base_link");
-  this->declare_parameter<bool>("require_enable_button", true);
-  this->declare_parameter<int64_t>("enable_button", 5);
-  this->declare_parameter<int64_t>("enable_turbo_button", -1);
-  this->declare_parameter<bool>("inverted_reverse", false);
   this->declare_parameter<std::string>("control_mode", "manual_control");
-
-  this->declare_parameters<int64_t>("axis_chassis", {{"x", 5L}, {"y", -1L}, {"yaw", -1L}});
-  this->declare_parameters<int64_t>(
-    "axis_gimbal", {{"yaw", 3L}, {"pitch", 4L}, {"roll", -1L}, {"shoot", 5L}});
-  this->declare_parameters<double>("scale_chassis", {{"x", 0.5}, {"y", 0.0}, {"yaw", 0.0}});
-  this->declare_parameters<double>("scale_chassis_turbo", {{"x", 1.0}, {"y", 0.0}, {"yaw", 0.0}});
-  this->declare_parameters<double>(
-    "scale_gimbal", {{"yaw", 0.5}, {"pitch", 0.0}, {"roll", 0.0}, {"shoot", 1.0}});
-  this->declare_parameters<double>(
-    "scale_gimbal_turbo", {{"yaw", 1.0}, {"pitch", 0.0}, {"roll", 0.0}, {"shoot", 1.0}});
+  this->declare_parameter<double>("hot_path_log_period", 1.0);
+  this->declare_parameter<bool>("use_serialized_joy", false);
+  this->declare_parameter<std::string>("input_backend", "joy");
+  this->declare_parameter<std::string>("rc.device", "/dev/ttyUSB0");
+  this->declare_parameter<double>("rc.timeout", 0.1);
+  this->declare_parameter<int64_t>("bridge.domain_id", -1);
+  this->declare_parameter<bool>("bridge.outputs", true);
+  this->declare_parameter<bool>("bridge.joy", false);
+  this->declare_parameter<bool>("skip_unsubscribed_outputs", false);
+  this->declare_parameter<double>("output_deadline", 0.0);
+  this->declare_parameter<double>("publisher_health_period", 0.5);
+  this->declare_parameter<double>("publisher_health_slow_publish", 0.001);
+  this->declare_parameter<bool>("statistics.enable", false);
+  this->declare_parameter<double>("statistics.period", 1.0);
+  this->declare_parameter<double>("statistics.callback_budget", 0.0005);
+  this->declare_parameter<double>("statistics.latency_budget", 0.01);
+  this->declare_parameter<bool>("statistics.hardware_counters", false);
+  this->declare_parameter<bool>("goal_snap.enable", false);
+  this->declare_parameter<std::string>("goal_snap.costmap_topic", "global_costmap/costmap");
+  this->declare_parameter<int64_t>("goal_snap.occupied_threshold", 99);
+  this->declare_parameter<double>("goal_snap.max_distance", 0.5);
+  this->declare_parameter<bool>("goal_snap.allow_unknown", false);
+  this->declare_parameter<bool>("shadow.enable", false);
+  this->declare_parameter<std::string>("shadow.namespace", "shadow");
+  this->declare_parameter<bool>("trajectory.enable", false);
+  this->declare_parameter<double>("trajectory.period", 0.02);
+  this->declare_parameter<double>("trajectory.horizon", 0.1);
+  this->declare_parameter<int64_t>("trajectory.points", 10);
+  this->declare_parameter<bool>("persistence.enable", false);
+  this->declare_parameter<std::string>("persistence.path", "/dev/shm/pb_teleop_twist_joy_state");
+  this->declare_parameter<double>("persistence.max_age", 1.0);
+  this->declare_parameter<bool>("mailbox.enable", false);
+  this->declare_parameter<std::string>("mailbox.name", "/pb_teleop_command");
+  this->declare_parameter<bool>("formation.enable", false);
+  this->declare_parameter<std::vector<std::string>>("formation.robots", std::vector<std::string>());
+  this->declare_parameter<std::vector<double>>("formation.offsets", std::vector<double>());
+  this->declare_parameter<std::string>("formation.pose_topic", "pose");
+  this->declare_parameter<std::string>("formation.cmd_vel_topic", "cmd_vel");
+  this->declare_parameter<double>("formation.position_gain", 1.0);
+  this->declare_parameter<double>("formation.yaw_gain", 1.0);
+  this->declare_parameter<double>("formation.max_linear_correction", 0.5);
+  this->declare_parameter<double>("formation.max_angular_correction", 0.5);
+  this->declare_parameter<double>("formation.pose_timeout", 0.5);
+  this->declare_parameter<bool>("power_governor.enable", false);
+  this->declare_parameter<std::string>("power_governor.power_topic", "referee/chassis_power");
+  this->declare_parameter<std::string>("power_governor.buffer_topic", "referee/buffer_energy");
+  this->declare_parameter<std::string>("power_governor.limit_topic", "referee/chassis_power_limit");
+  this->declare_parameter<double>("power_governor.default_limit", 45.0);
+  this->declare_parameter<double>("power_governor.static_power", 3.0);
+  this->declare_parameter<std::vector<double>>(
+    "power_governor.linear_coefficients", std::vector<double>{8.0, 8.0, 2.0});
+  this->declare_parameter<std::vector<double>>(
+    "power_governor.quadratic_coefficients", std::vector<double>{12.0, 12.0, 1.5});
+  this->declare_parameter<double>("power_governor.buffer_reserve", 20.0);
+  this->declare_parameter<double>("power_governor.buffer_horizon", 1.0);
+  this->declare_parameter<double>("power_governor.telemetry_timeout", 0.5);
+  this->declare_parameter<double>("power_governor.correction_rate", 0.05);
+  this->declare_parameter<bool>("pipeline.enable", false);
+  this->declare_parameter<int64_t>("pipeline.queue_size", 64);
+  this->declare_parameter<std::vector<int64_t>>("pipeline.cpus", std::vector<int64_t>());
+  this->declare_parameter<bool>("phase_lock.enable", false);
+  this->declare_parameter<std::string>("phase_lock.tick_topic", "controller_tick");
+  this->declare_parameter<double>("phase_lock.controller_period", 0.001);
+  this->declare_parameter<double>("phase_lock.publish_offset", 0.0002);
+  this->declare_parameter<int64_t>("phase_lock.publish_divider", 10);
+  this->declare_parameter<double>("phase_lock.input_timeout", 0.5);
 
   this->get_parameter("publish_stamped_twist", publish_stamped_twist_);
   this->get_parameter("robot_base_frame", robot_base_frame_);
-  this->get_parameter("require_enable_button", require_enable_button_);
-  this->get_parameter("enable_button", enable_button_);
-  this->get_parameter("enable_turbo_button", enable_turbo_button_);
-  this->get_parameter("inverted_reverse", inverted_reverse_);
   this->get_parameter("control_mode", control_mode_);
-  this->get_parameters("axis_chassis", axis_chassis_map_);
-  this->get_parameters("axis_gimbal", axis_gimbal_map_);
-  this->get_parameters("scale_chassis", scale_chassis_map_["normal"]);
-  this->get_parameters("scale_chassis_turbo", scale_chassis_map_["turbo"]);
-  this->get_parameters("scale_gimbal", scale_gimbal_map_["normal"]);
-  this->get_parameters("scale_gimbal_turbo", scale_gimbal_map_["turbo"]);
+  this->get_parameter("skip_unsubscribed_outputs", skip_unsubscribed_outputs_);
+  this->get_parameter("statistics.enable", statistics_enable_);
+  callback_budget_ns_ = static_cast<int64_t>(
+    this->get_parameter("statistics.callback_budget").as_double() * 1e9);
+  latency_budget_ns_ =
+    static_cast<int64_t>(this->get_parameter("statistics.latency_budget").as_double() * 1e9);
+  this->get_parameter("phase_lock.enable", phase_lock_enable_);
+  this->get_parameter("phase_lock.input_timeout", phase_lock_input_timeout_);
+
+  NodeParameterSource parameter_source(this);
+  mapping_config_ = loadMappingConfig(&parameter_source);
+  for (const auto & warning : mapping_config_.warnings) {
+    RCLCPP_ERROR(this->get_logger(), "%s", warning.c_str());
+  }
+  if (!teleop_mapper_.configure(mapping_config_)) {
+    RCLCPP_ERROR(
+      this->get_logger(), "Joint output indices are not a permutation, using list order.");
+  }
+  joint_state_msg_.name = teleop_mapper_.joints().names();
+  joint_state_msg_.position.resize(teleop_mapper_.joints().size());
+  if (this->get_parameter("shadow.enable").as_bool()) {
+    setupShadow(&parameter_source);
+  }
+
+  if (this->get_parameter("persistence.enable").as_bool()) {
+    std::string path = this->get_parameter("persistence.path").as_string();
+    std::string error;
+    std::vector<double> joints;
+    SpeedProfile profile = SpeedProfile::DISABLED;
+    if (!runtime_state_file_.open(path, teleop_mapper_.joints().names(), &error)) {
+      RCLCPP_ERROR(this->get_logger(), "Runtime state persistence disabled: %s", error.c_str());
+    } else if (runtime_state_file_.restore(
+                 static_cast<int64_t>(this->get_parameter("persistence.max_age").as_double() * 1e9),
+                 &joints, &profile)) {
+      teleop_mapper_.joints().restore(joints);
+      // Moving before the restart: stop on the first disabled input.
+      sent_disable_msg_ = profile != SpeedProfile::DISABLED;
+      RCLCPP_INFO(this->get_logger(), "Resumed runtime state from %s.", path.c_str());
+    }
+  }
+
+  double hot_path_log_period = this->get_parameter("hot_path_log_period").as_double();
+  tf_failure_log_site_ = throttled_logger_.registerSite(
+    RCUTILS_LOG_SEVERITY_WARN, "Failed to transform goal pose from %s to map: %s",
+    hot_path_log_period);
+  malformed_joy_log_site_ = throttled_logger_.registerSite(
+    RCUTILS_LOG_SEVERITY_WARN, "Dropping malformed serialized joy message.", hot_path_log_period);
+  rc_error_log_site_ = throttled_logger_.registerSite(
+    RCUTILS_LOG_SEVERITY_ERROR, "RC receiver on %s: %s", hot_path_log_period);
+  goal_blocked_log_site_ = throttled_logger_.registerSite(
+    RCUTILS_LOG_SEVERITY_WARN, "No free cell near goal, not sending it.", hot_path_log_period);
+
+  last_goal_time_ = rclcpp::Time(0, 0, this->get_clock()->get_clock_type());
+  latest_joy_time_ = rclcpp::Time(0, 0, this->get_clock()->get_clock_type());
+  // A backwards jump (simulation reset, looping bag) restarts integration and throttling.
+  rcl_jump_threshold_t jump_threshold;
+  jump_threshold.on_clock_change = true;
+  jump_threshold.min_forward.nanoseconds = 0;
+  jump_threshold.min_backward.nanoseconds = -1;
+  time_jump_handler_ = this->get_clock()->create_jump_handler(
+    rclcpp::JumpHandler::pre_callback_t(),
+    [this](const rcl_time_jump_t & /*jump*/) { time_jumped_ = true; }, jump_threshold);
 
   if (control_mode_ == "auto_control") {
     nav_to_pose_client_ =
       rclcpp_action::create_client<nav2_msgs::action::NavigateToPose>(this, "navigate_to_pose");
+    this->get_parameter("goal_snap.enable", goal_snap_enable_);
+  }
+  if (goal_snap_enable_) {
+    this->get_parameter("goal_snap.occupied_threshold", goal_snap_occupied_threshold_);
+    this->get_parameter("goal_snap.max_distance", goal_snap_max_distance_);
+    this->get_parameter("goal_snap.allow_unknown", goal_snap_allow_unknown_);
+    // The full costmap is latched and rare, updates carry the changed window.
+    std::string costmap_topic = this->get_parameter("goal_snap.costmap_topic").as_string();
+    costmap_sub_ = this->create_subscription<nav_msgs::msg::OccupancyGrid>(
+      costmap_topic, rclcpp::QoS(1).transient_local().reliable(),
+      std::bind(&TeleopTwistJoyNode::costmapCallback, this, std::placeholders::_1));
+    costmap_update_sub_ = this->create_subscription<map_msgs::msg::OccupancyGridUpdate>(
+      costmap_topic + "_updates", rclcpp::QoS(10),
+      std::bind(&TeleopTwistJoyNode::costmapUpdateCallback, this, std::placeholders::_1));
+  }
+
+  int64_t bridge_domain_id = this->get_parameter("bridge.domain_id").as_int();
+  if (bridge_domain_id >= 0) {
+    setupBridge(options, static_cast<size_t>(bridge_domain_id));
+  }
+  rclcpp::Node * output_node = this;
+  rclcpp::Node * input_node = this;
+  if (bridge_node_ && this->get_parameter("bridge.outputs").as_bool()) {
+    output_node = bridge_node_.get();
+  }
+  if (bridge_node_ && this->get_parameter("bridge.joy").as_bool()) {
+    input_node = bridge_node_.get();
+  }
+
+  // An offered deadline lets slow or stalled consumers show up as QoS events.
+  rclcpp::QoS output_qos(10);
+  double output_deadline = this->get_parameter("output_deadline").as_double();
+  if (output_deadline > 0.0) {
+    output_qos.deadline(rclcpp::Duration::from_seconds(output_deadline));
   }
 
   if (publish_stamped_twist_) {
-    cmd_vel_stamped_pub_ = this->create_publisher<geometry_msgs::msg::TwistStamped>("cmd_vel", 10);
+    cmd_vel_stamped_pub_ = output_node->create_publisher<geometry_msgs::msg::TwistStamped>(
+      "cmd_vel", output_qos, cmd_vel_health_.makeOptions());
+  } else {
+    cmd_vel_pub_ = output_node->create_publisher<geometry_msgs::msg::Twist>(
+      "cmd_vel", output_qos, cmd_vel_health_.makeOptions());
+  }
+  joint_state_pub_ = output_node->create_publisher<sensor_msgs::msg::JointState>(
+    "cmd_gimbal_joint", output_qos, joint_state_health_.makeOptions());
+  shoot_pub_ = output_node->create_publisher<example_interfaces::msg::UInt8>(
+    "cmd_shoot", output_qos, shoot_health_.makeOptions());
+  if (this->get_parameter("trajectory.enable").as_bool()) {
+    trajectory_steps_ = static_cast<size_t>(
+      std::max<int64_t>(this->get_parameter("trajectory.points").as_int(), 1));
+    double horizon = this->get_parameter("trajectory.horizon").as_double();
+    trajectory_step_ = horizon / static_cast<double>(trajectory_steps_);
+    trajectory_period_ns_ =
+      static_cast<int64_t>(this->get_parameter("trajectory.period").as_double() * 1e9);
+    // The first point is the current setpoint, then one per step.
+    const size_t num_joints = teleop_mapper_.joints().size();
+    trajectory_positions_.resize(trajectory_steps_ * num_joints);
+    trajectory_velocities_.resize(trajectory_steps_ * num_joints);
+    trajectory_msg_.joint_names = teleop_mapper_.joints().names();
+    trajectory_msg_.points.resize(trajectory_steps_ + 1);
+    for (size_t k = 0; k <= trajectory_steps_; ++k) {
+      trajectory_msg_.points[k].positions.resize(num_joints);
+      trajectory_msg_.points[k].velocities.resize(num_joints);
+      trajectory_msg_.points[k].time_from_start =
+        rclcpp::Duration::from_seconds(trajectory_step_ * static_cast<double>(k));
+    }
+    trajectory_pub_ = output_node->create_publisher<trajectory_msgs::msg::JointTrajectory>(
+      "cmd_gimbal_trajectory", output_qos);
+    trajectory_enable_ = true;
+  }
+  const int64_t slow_publish_ns = static_cast<int64_t>(
+    this->get_parameter("publisher_health_slow_publish").as_double() * 1e9);
+  cmd_vel_health_.setSlowPublishThreshold(slow_publish_ns);
+  joint_state_health_.setSlowPublishThreshold(slow_publish_ns);
+  shoot_health_.setSlowPublishThreshold(slow_publish_ns);
+  publisher_health_timer_ = rclcpp::create_timer(
+    this, this->get_clock(),
+    rclcpp::Duration::from_seconds(this->get_parameter("publisher_health_period").as_double()),
+    std::bind(&TeleopTwistJoyNode::pollPublisherHealth, this));
+  if (this->get_parameter("pipeline.enable").as_bool()) {
+    if (phase_lock_enable_) {
+      RCLCPP_ERROR(this->get_logger(), "Pipeline mode does not combine with phase lock, disabled.");
+    } else {
+      setupPipeline();
+    }
+  }
+
+  std::string input_backend = this->get_parameter("input_backend").as_string();
+  bool rc_input = input_backend == "dbus" || input_backend == "sbus";
+  if (!rc_input && input_backend != "joy") {
+    RCLCPP_ERROR(
+      this->get_logger(), "Unknown input_backend %s, using joy.", input_backend.c_str());
+  }
+  if (rc_input) {
+    // The reader thread starts once all outputs are set up.
+  } else if (this->get_parameter("use_serialized_joy").as_bool()) {
+    // Decode only the bound axes and buttons straight from the CDR buffer.
+    bindJoyDecoder();
+    joy_serialized_sub_ = input_node->create_generic_subscription(
+      "joy", "sensor_msgs/msg/Joy", rclcpp::QoS(10),
+      std::bind(&TeleopTwistJoyNode::serializedJoyCallback, this, std::placeholders::_1));
   } else {
-    cmd_vel_pub_ = this->create_publisher<geometry_msgs::msg::Twist>("cmd_vel", 10);
+    joy_sub_ = input_node->create_subscription<sensor_msgs::msg::Joy>(
+      "joy", 10, std::bind(&TeleopTwistJoyNode::joyCallback, this, std::placeholders::_1));
+  }
+
+  if (this->get_parameter("mailbox.enable").as_bool()) {
+    std::string mailbox_name = this->get_parameter("mailbox.name").as_string();
+    std::string error;
+    if (command_mailbox_.open(mailbox_name, &error)) {
+      RCLCPP_INFO(this->get_logger(), "Writing commands to mailbox %s.", mailbox_name.c_str());
+    } else {
+      RCLCPP_ERROR(this->get_logger(), "Command mailbox disabled: %s", error.c_str());
+    }
+  }
+
+  if (this->get_parameter("formation.enable").as_bool()) {
+    setupFormation();
+  }
+  if (this->get_parameter("power_governor.enable").as_bool()) {
+    setupPowerGovernor();
+  }
+
+  if (statistics_enable_) {
+    // The counters follow one thread, the pipeline spreads over three.
+    perf_counters_.setEnabled(
+      this->get_parameter("statistics.hardware_counters").as_bool() && !pipeline_enable_);
+    diagnostics_pub_ =
+      this->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("diagnostics", 10);
+    statistics_timer_ = rclcpp::create_timer(
+      this, this->get_clock(),
+      rclcpp::Duration::from_seconds(this->get_parameter("statistics.period").as_double()),
+      std::bind(&TeleopTwistJoyNode::publishStatistics, this));
+  }
+
+  if (phase_lock_enable_) {
+    std::string tick_topic = this->get_parameter("phase_lock.tick_topic").as_string();
+    double controller_period = this->get_parameter("phase_lock.controller_period").as_double();
+    double publish_offset = this->get_parameter("phase_lock.publish_offset").as_double();
+    int64_t publish_divider = this->get_parameter("phase_lock.publish_divider").as_int();
+    phase_lock_ = std::make_unique<PhaseLock>(
+      static_cast<int64_t>(controller_period * 1e9), static_cast<int64_t>(publish_offset * 1e9),
+      publish_divider);
+    phase_error_pub_ =
+      this->create_publisher<example_interfaces::msg::Float64>("~/phase_error", 10);
+    controller_tick_sub_ = this->create_subscription<sensor_msgs::msg::JointState>(
+      tick_topic, rclcpp::SensorDataQoS(),
+      std::bind(&TeleopTwistJoyNode::controllerTickCallback, this, std::placeholders::_1));
+    rcl_jump_threshold_t clock_threshold;
+    clock_threshold.on_clock_change = true;
+    clock_threshold.min_forward.nanoseconds = 1;
+    clock_threshold.min_backward.nanoseconds = -1;
+    phase_lock_clock_handler_ = this->get_clock()->create_jump_handler(
+      rclcpp::JumpHandler::pre_callback_t(),
+      [this](const rcl_time_jump_t & jump) {
+        if (jump.clock_change != RCL_ROS_TIME_NO_CHANGE || jump.delta.nanoseconds < 0) {
+          // The tick estimate and the pending target belong to the old timeline.
+          {
+            std::lock_guard<std::mutex> lock(phase_lock_mutex_);
+            phase_lock_->reset();
+          }
+          std::lock_guard<std::mutex> lock(phase_lock_wait_mutex_);
+          phase_lock_rescheduled_ = true;
+        }
+        phase_lock_wait_cv_.notify_all();
+      },
+      clock_threshold);
+    phase_lock_thread_ = std::thread(&TeleopTwistJoyNode::phaseLockLoop, this);
+    RCLCPP_INFO(
+      this->get_logger(), "Phase lock on %s, publishing %.3f ms before every %" PRId64 ". sample.",
+      tick_topic.c_str(), publish_offset * 1e3, publish_divider);
   }
-  joint_state_pub_ = this->create_publisher<sensor_msgs::msg::JointState>("cmd_gimbal_joint", 10);
-  shoot_pub_ = this->create_publisher<example_interfaces::msg::UInt8>("cmd_shoot", 10);
-  joy_sub_ = this->create_subscription<sensor_msgs::msg::Joy>(
-    "joy", 10, std::bind(&TeleopTwistJoyNode::joyCallback, this, std::placeholders::_1));
 
-  RCLCPP_INFO(this->get_logger(), "Teleop enable button %" PRId64 ".", enable_button_);
-  RCLCPP_INFO(this->get_logger(), "Turbo on button %" PRId64 ".", enable_turbo_button_);
+  if (rc_input) {
+    setupRcInput(input_backend == "dbus" ? RcProtocol::DBUS : RcProtocol::SBUS);
+  }
+
+  RCLCPP_INFO(
+    this->get_logger(), "Teleop enable button %" PRId64 ".", mapping_config_.enable_button);
+  RCLCPP_INFO(
+    this->get_logger(), "Turbo on button %" PRId64 ".", mapping_config_.enable_turbo_button);
   RCLCPP_INFO(this->get_logger(), "%s", "Teleop enable inverted reverse.");
 
-  for (std::map<std::string, int64_t>::iterator it = axis_chassis_map_.begin();
-       it != axis_chassis_map_.end(); ++it) {
+  for (std::map<std::string, int64_t>::iterator it = mapping_config_.axis_chassis.begin();
+       it != mapping_config_.axis_chassis.end(); ++it) {
     if (it->second != -1L) {
       RCLCPP_INFO(
         this->get_logger(), "Linear axis %s on %" PRId64 " at scale %f.", it->first.c_str(),
-        it->second, scale_chassis_map_["normal"][it->first]);
+        it->second, mapping_config_.scale_chassis["normal"][it->first]);
     }
-    if (enable_turbo_button_ >= 0 && it->second != -1) {
+    if (mapping_config_.enable_turbo_button >= 0 && it->second != -1) {
       RCLCPP_INFO(
         this->get_logger(), "Turbo for linear axis %s is scale %f.", it->first.c_str(),
-        scale_chassis_map_["turbo"][it->first]);
+        mapping_config_.scale_chassis["turbo"][it->first]);
     }
   }
 
-  for (std::map<std::string, int64_t>::iterator it = axis_gimbal_map_.begin();
-       it != axis_gimbal_map_.end(); ++it) {
+  for (std::map<std::string, int64_t>::iterator it = mapping_config_.axis_gimbal.begin();
+       it != mapping_config_.axis_gimbal.end(); ++it) {
     if (it->second != -1L) {
       RCLCPP_INFO(
         this->get_logger(), "Angular axis %s on %" PRId64 " at scale %f.", it->first.c_str(),
-        it->second, scale_gimbal_map_["normal"][it->first]);
+        it->second, mapping_config_.scale_gimbal["normal"][it->first]);
     }
-    if (enable_turbo_button_ >= 0 && it->second != -1) {
+    if (mapping_config_.enable_turbo_button >= 0 && it->second != -1) {
       RCLCPP_INFO(
         this->get_logger(), "Turbo for angular axis %s is scale %f.", it->first.c_str(),
-        scale_gimbal_map_["turbo"][it->first]);
+        mapping_config_.scale_gimbal["turbo"][it->first]);
+    }
+  }
+
+  for (const auto & binding : mapping_config_.joints) {
+    if (binding.axis != -1L) {
+      RCLCPP_INFO(
+        this->get_logger(), "Joint %s on axis %" PRId64 " at scale %f (turbo %f).",
+        binding.name.c_str(), binding.axis, binding.scale, binding.scale_turbo);
     }
   }
 }
 
-double TeleopTwistJoyNode::getVal(
-  const sensor_msgs::msg::Joy::SharedPtr joy_msg, const std::map<std::string, int64_t> & axis_map,
-  const std::map<std::string, double> & scale_map, const std::string & fieldname)
+TeleopTwistJoyNode::~TeleopTwistJoyNode()
 {
-  auto axis_it = axis_map.find(fieldname);
-  auto scale_it = scale_map.find(fieldname);
-
-  if (
-    axis_it == axis_map.end() || axis_it->second == -1L || scale_it == scale_map.end() ||
-    static_cast<int>(joy_msg->axes.size()) <= axis_it->second) {
-    return 0.0;
+  pipeline_stop_ = true;
+  for (std::thread & thread : pipeline_threads_) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+  if (bridge_executor_) {
+    bridge_executor_->cancel();
+    bridge_thread_.join();
+  }
+  rc_stop_ = true;
+  if (rc_thread_.joinable()) {
+    rc_thread_.join();
+  }
+  phase_lock_stop_ = true;
+  phase_lock_wait_cv_.notify_all();
+  if (phase_lock_thread_.joinable()) {
+    phase_lock_thread_.join();
   }
-
-  return joy_msg->axes[axis_it->second] * scale_it->second;
 }
 
 void TeleopTwistJoyNode::fillShootMsg(
-  const sensor_msgs::msg::Joy::SharedPtr joy_msg, const std::string & which_map,
-  example_interfaces::msg::UInt8 * shoot_msg)
+  const TeleopCommand & command, example_interfaces::msg::UInt8 * shoot_msg)
 {
-  shoot_msg->data = getVal(joy_msg, axis_gimbal_map_, scale_gimbal_map_[which_map], "shoot");
+  {
+    PerfScope scope(&perf_counters_, PerfStage::FILL);
+    shoot_msg->data = command.shoot;
+  }
+  PerfScope scope(&perf_counters_, PerfStage::PUBLISH);
+  int64_t publish_start_ns = steadyNowNs();
   shoot_pub_->publish(*shoot_msg);
+  shoot_health_.recordPublish(steadyNowNs() - publish_start_ns);
 }
 
 void TeleopTwistJoyNode::joyCallback(const sensor_msgs::msg::Joy::SharedPtr joy_msg)
 {
-  // Calculate the frequency of the callback function
-  static auto last_time = this->now();
-  auto current_time = this->now();
-  dt_ = (current_time - last_time).seconds();
-  last_time = current_time;
+  if (pipeline_enable_) {
+    PipelineInput * input = pipeline_input_ring_->producerSlot();
+    if (input == nullptr) {
+      ++pipeline_dropped_[PIPELINE_DECODE];
+      return;
+    }
+    input->joy_msg = joy_msg;
+    input->received_ns = steadyNowNs();
+    pipeline_input_ring_->push();
+    return;
+  }
+  JoySnapshot joy;
+  toJoySnapshot(*joy_msg, &joy);
+  onJoyInput(joy);
+}
 
-  if (
-    enable_turbo_button_ >= 0 && static_cast<int>(joy_msg->buttons.size()) > enable_turbo_button_ &&
-    joy_msg->buttons[enable_turbo_button_]) {
-    sendCmdVelMsg(joy_msg, "turbo");
-  } else if (
-    !require_enable_button_ || (static_cast<int>(joy_msg->buttons.size()) > enable_button_ &&
-                                joy_msg->buttons[enable_button_])) {
-    sendCmdVelMsg(joy_msg, "normal");
+void TeleopTwistJoyNode::serializedJoyCallback(
+  std::shared_ptr<rclcpp::SerializedMessage> serialized_msg)
+{
+  if (pipeline_enable_) {
+    PipelineInput * input = pipeline_input_ring_->producerSlot();
+    if (input == nullptr) {
+      ++pipeline_dropped_[PIPELINE_DECODE];
+      return;
+    }
+    input->serialized_msg = std::move(serialized_msg);
+    input->received_ns = steadyNowNs();
+    pipeline_input_ring_->push();
+    return;
+  }
+  const rcl_serialized_message_t & buffer = serialized_msg->get_rcl_serialized_message();
+  if (!joy_decoder_.decode(buffer.buffer, buffer.buffer_length, &serialized_joy_)) {
+    throttled_logger_.log(malformed_joy_log_site_);
+    return;
+  }
+  onJoyInput(serialized_joy_);
+}
+
+void TeleopTwistJoyNode::onJoyInput(const JoySnapshot & joy)
+{
+  if (phase_lock_enable_) {
+    std::lock_guard<std::mutex> lock(phase_lock_mutex_);
+    latest_joy_ = joy;
+    latest_joy_valid_ = true;
+    latest_joy_time_ = this->now();
+    return;
+  }
+  if (pipeline_enable_) {
+    // Decoded on the RC receiver thread, straight to the mapping stage.
+    PipelineJoy * item = pipeline_joy_ring_->producerSlot();
+    if (item == nullptr) {
+      ++pipeline_dropped_[PIPELINE_MAPPING];
+      return;
+    }
+    item->joy = joy;
+    item->received_ns = steadyNowNs();
+    item->queued_ns = item->received_ns;
+    pipeline_joy_ring_->push();
+    return;
+  }
+  processJoy(joy);
+}
+
+void TeleopTwistJoyNode::setupBridge(const rclcpp::NodeOptions & options, size_t domain_id)
+{
+  // Logging is already set up by the default context.
+  rclcpp::InitOptions init_options;
+  init_options.auto_initialize_logging(false);
+  init_options.set_domain_id(domain_id);
+  bridge_context_ = std::make_shared<rclcpp::Context>();
+  try {
+    bridge_context_->init(0, nullptr, init_options);
+    // Same name, namespace and remappings, only the domain differs.
+    rclcpp::NodeOptions bridge_options;
+    bridge_options.context(bridge_context_)
+      .arguments(options.arguments())
+      .start_parameter_services(false)
+      .start_parameter_event_publisher(false)
+      .enable_rosout(false);
+    bridge_node_ =
+      std::make_shared<rclcpp::Node>(this->get_name(), this->get_namespace(), bridge_options);
+  } catch (const std::exception & ex) {
+    RCLCPP_ERROR(this->get_logger(), "Domain bridge disabled: %s", ex.what());
+    bridge_context_.reset();
+    return;
+  }
+
+  // Spun on its own thread for the joy subscription and the QoS events.
+  rclcpp::ExecutorOptions executor_options;
+  executor_options.context = bridge_context_;
+  bridge_executor_ = std::make_shared<rclcpp::executors::SingleThreadedExecutor>(executor_options);
+  bridge_executor_->add_node(bridge_node_);
+  bridge_thread_ = std::thread([this]() { bridge_executor_->spin(); });
+  RCLCPP_INFO(this->get_logger(), "Bridging to ROS domain %zu.", domain_id);
+}
+
+void TeleopTwistJoyNode::setupRcInput(RcProtocol protocol)
+{
+  rc_protocol_ = protocol;
+  rc_device_ = this->get_parameter("rc.device").as_string();
+  rc_timeout_ns_ = static_cast<int64_t>(this->get_parameter("rc.timeout").as_double() * 1e9);
+  rc_decoder_ = std::make_unique<RcFrameDecoder>(protocol);
+  rc_thread_ = std::thread(&TeleopTwistJoyNode::rcInputLoop, this);
+  RCLCPP_INFO(
+    this->get_logger(), "Reading %s receiver from %s.",
+    protocol == RcProtocol::DBUS ? "DBUS" : "SBUS", rc_device_.c_str());
+}
+
+void TeleopTwistJoyNode::rcInputLoop()
+{
+  // Frames are delimited by line silence, so the gaps are timed on the steady
+  // clock. Snapshots are stamped on the node clock like the joy topic.
+  const auto frame_gap = std::chrono::milliseconds(3);
+  const auto reopen_period = std::chrono::milliseconds(100);
+  const auto timeout = std::chrono::nanoseconds(rc_timeout_ns_);
+  uint8_t buffer[256];
+  JoySnapshot joy;
+  auto last_byte_time = std::chrono::steady_clock::now();
+  auto last_frame_time = last_byte_time;
+  bool receiving = false;
+  while (rclcpp::ok() && !rc_stop_) {
+    if (!rc_port_.isOpen()) {
+      // Also retried after errors, USB adapters come and go with the cable.
+      std::string error;
+      if (!rc_port_.open(rc_device_, rc_protocol_, &error)) {
+        throttled_logger_.log(rc_error_log_site_, rc_device_.c_str(), error.c_str());
+        std::this_thread::sleep_for(reopen_period);
+        continue;
+      }
+      rc_decoder_->resync();
+    }
+
+    ssize_t count = rc_port_.read(buffer, sizeof(buffer), 10);
+    auto now = std::chrono::steady_clock::now();
+    if (count < 0) {
+      throttled_logger_.log(rc_error_log_site_, rc_device_.c_str(), std::strerror(errno));
+      rc_port_.close();
+    } else if (count > 0) {
+      if (now - last_byte_time > frame_gap) {
+        rc_decoder_->resync();
+      }
+      last_byte_time = now;
+      for (ssize_t i = 0; i < count; ++i) {
+        if (rc_decoder_->push(buffer[i], &joy)) {
+          joy.stamp_ns = this->now().nanoseconds();
+          onJoyInput(joy);
+          last_frame_time = now;
+          receiving = true;
+        }
+      }
+    }
+
+    if (receiving && now - last_frame_time > timeout) {
+      // Receiver or cable lost: release everything once, which stops the robot.
+      throttled_logger_.log(rc_error_log_site_, rc_device_.c_str(), "no valid frame, stopping");
+      JoySnapshot released;
+      released.stamp_ns = this->now().nanoseconds();
+      onJoyInput(released);
+      receiving = false;
+    }
+  }
+}
+
+void TeleopTwistJoyNode::controllerTickCallback(
+  const sensor_msgs::msg::JointState::SharedPtr tick_msg)
+{
+  // Prefer the controller's own sample stamp, fall back to the arrival time.
+  rclcpp::Time tick_time(tick_msg->header.stamp, this->get_clock()->get_clock_type());
+  if (tick_time.nanoseconds() == 0) {
+    tick_time = this->now();
+  }
+  int64_t phase_error_ns = 0;
+  bool matched = false;
+  bool rescheduled = false;
+  {
+    std::lock_guard<std::mutex> lock(phase_lock_mutex_);
+    uint64_t resets = phase_lock_->resets();
+    matched = phase_lock_->onTick(tick_time.nanoseconds(), &phase_error_ns);
+    rescheduled = phase_lock_->resets() != resets;
+  }
+  if (rescheduled) {
+    // The controller restarted behind our schedule, wake the publish loop.
+    {
+      std::lock_guard<std::mutex> lock(phase_lock_wait_mutex_);
+      phase_lock_rescheduled_ = true;
+    }
+    phase_lock_wait_cv_.notify_all();
+  }
+  if (matched) {
+    example_interfaces::msg::Float64 phase_error_msg;
+    phase_error_msg.data = static_cast<double>(phase_error_ns) * 1e-9;
+    phase_error_pub_->publish(phase_error_msg);
+  }
+}
+
+void TeleopTwistJoyNode::phaseLockLoop()
+{
+  auto clock = this->get_clock();
+  while (rclcpp::ok() && !phase_lock_stop_) {
+    int64_t target_ns = 0;
+    {
+      std::lock_guard<std::mutex> lock(phase_lock_mutex_);
+      target_ns = phase_lock_->nextPublishTime(clock->now().nanoseconds());
+    }
+    if (!waitForPhaseLock(clock, target_ns)) {
+      break;
+    }
+
+    JoySnapshot joy;
+    bool joy_valid = false;
+    {
+      std::lock_guard<std::mutex> lock(phase_lock_mutex_);
+      if (
+        latest_joy_valid_ &&
+        (clock->now() - latest_joy_time_).seconds() > phase_lock_input_timeout_) {
+        // Input went silent, do not keep replaying the last command.
+        latest_joy_valid_ = false;
+      }
+      joy = latest_joy_;
+      joy_valid = latest_joy_valid_;
+    }
+    if (joy_valid) {
+      processJoy(joy);
+    } else if (sent_disable_msg_) {
+      sendZeroCommand();
+      sent_disable_msg_ = false;
+      if (command_mailbox_.isOpen()) {
+        command_mailbox_.write(
+          TeleopCommand(), teleop_mapper_.joints().positions(), clock->now().nanoseconds());
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(phase_lock_mutex_);
+    phase_lock_->notePublished(clock->now().nanoseconds());
+  }
+}
+
+bool TeleopTwistJoyNode::waitForPhaseLock(const rclcpp::Clock::SharedPtr & clock, int64_t target_ns)
+{
+  // Bounded, so the stop flag is checked even when the clock does not move.
+  const int64_t max_wait_ns = 100000000;
+  std::unique_lock<std::mutex> lock(phase_lock_wait_mutex_);
+  while (rclcpp::ok() && !phase_lock_stop_) {
+    if (phase_lock_rescheduled_) {
+      phase_lock_rescheduled_ = false;
+      std::lock_guard<std::mutex> phase_lock(phase_lock_mutex_);
+      target_ns = phase_lock_->nextPublishTime(clock->now().nanoseconds());
+    }
+    int64_t remaining_ns = target_ns - clock->now().nanoseconds();
+    if (remaining_ns <= 0) {
+      return true;
+    }
+    phase_lock_wait_cv_.wait_for(
+      lock, std::chrono::nanoseconds(std::min(remaining_ns, max_wait_ns)));
+  }
+  return false;
+}
+
+void TeleopTwistJoyNode::processJoy(const JoySnapshot & joy)
+{
+  int64_t start_ns = steadyNowNs();
+  PerfScope total_scope(&perf_counters_, PerfStage::TOTAL);
+  TeleopCommand command;
+  double dt = mapJoy(joy, &command);
+  publishCommand(command, teleop_mapper_.joints().positions(), joy, dt, start_ns);
+
+  // After the live statistics, the shadow must not count against their budget.
+  if (shadow_enable_) {
+    runShadow(joy, dt);
+  }
+}
+
+double TeleopTwistJoyNode::mapJoy(const JoySnapshot & joy, TeleopCommand * command)
+{
+  // Integrate on the input stamp when there is one, so a replay produces the same
+  // setpoints whatever the clock rate. Latched input in phase lock mode is
+  // processed on the node clock instead.
+  int64_t input_time_ns =
+    (!phase_lock_enable_ && joy.stamp_ns != 0) ? joy.stamp_ns : this->now().nanoseconds();
+  if (time_jumped_.exchange(false)) {
+    last_input_time_ns_ = 0;
+  }
+  double dt = 0.0;
+  if (last_input_time_ns_ != 0) {
+    dt = static_cast<double>(input_time_ns - last_input_time_ns_) * 1e-9;
+    dt = std::min(std::max(dt, 0.0), teleop_mapper_.maxIntegrationDt());
+  }
+  last_input_time_ns_ = input_time_ns;
+
+  {
+    // The integrators keep running so a late subscriber gets a consistent setpoint.
+    PerfScope scope(&perf_counters_, PerfStage::MAPPING);
+    teleop_mapper_.map(joy, dt, command);
+  }
+  if (runtime_state_file_.isOpen()) {
+    runtime_state_file_.save(teleop_mapper_.joints().positions(), command->profile);
+  }
+  return dt;
+}
+
+void TeleopTwistJoyNode::publishCommand(
+  const TeleopCommand & command, const std::vector<double> & joints, const JoySnapshot & joy,
+  double dt, int64_t start_ns)
+{
+  const TeleopCommand * output = &command;
+  TeleopCommand governed;
+  if (power_governor_enable_ && command.profile != SpeedProfile::DISABLED) {
+    governed = command;
+    governChassisPower(&governed);
+    output = &governed;
+  } else if (power_governor_enable_) {
+    std::lock_guard<std::mutex> lock(power_governor_mutex_);
+    power_governor_.release();
+  }
+  if (command.profile != SpeedProfile::DISABLED) {
+    sendCmdVelMsg(*output, joints, dt);
   } else {
     // When enable button is released, immediately send a single no-motion command
     // in order to stop the robot.
@@ -154,70 +980,355 @@ void TeleopTwistJoyNode::joyCallback(const sensor_msgs::msg::Joy::SharedPtr joy_
       sent_disable_msg_ = false;
     }
   }
-  fillShootMsg(joy_msg, "normal", new example_interfaces::msg::UInt8());
+  if (outputWanted(shoot_health_)) {
+    example_interfaces::msg::UInt8 shoot_msg;
+    fillShootMsg(command, &shoot_msg);
+  }
+  if (command_mailbox_.isOpen()) {
+    PerfScope scope(&perf_counters_, PerfStage::PUBLISH);
+    command_mailbox_.write(*output, joints, this->now().nanoseconds());
+  }
+  if (trajectory_enable_) {
+    sendTrajectory(command, joints, joy);
+  }
+
+  if (statistics_enable_) {
+    int64_t elapsed_ns = steadyNowNs() - start_ns;
+    // Latched input in phase lock mode is counted once, on its first output.
+    int64_t latency_ns = -1;
+    if (joy.stamp_ns != 0 && joy.stamp_ns != last_latency_stamp_ns_) {
+      latency_ns = this->now().nanoseconds() - joy.stamp_ns;
+      last_latency_stamp_ns_ = joy.stamp_ns;
+    }
+    std::lock_guard<std::mutex> lock(statistics_mutex_);
+    callback_stats_.record(elapsed_ns);
+    if (callback_budget_ns_ > 0 && elapsed_ns > callback_budget_ns_) {
+      ++callback_over_budget_;
+    }
+    if (latency_ns >= 0) {
+      input_latency_stats_.record(latency_ns);
+      if (latency_budget_ns_ > 0 && latency_ns > latency_budget_ns_) {
+        ++input_latency_over_budget_;
+      }
+    }
+  }
+}
+
+void TeleopTwistJoyNode::sendTrajectory(
+  const TeleopCommand & command, const std::vector<double> & joints, const JoySnapshot & joy)
+{
+  int64_t now_ns = this->now().nanoseconds();
+  // Also restarts after a backwards clock jump.
+  if (
+    now_ns >= last_trajectory_time_ns_ &&
+    now_ns - last_trajectory_time_ns_ < trajectory_period_ns_) {
+    return;
+  }
+  last_trajectory_time_ns_ = now_ns;
+
+  {
+    // Predicted with the stick held over the horizon.
+    PerfScope scope(&perf_counters_, PerfStage::FILL);
+    teleop_mapper_.predictJoints(
+      joints, joy, command.profile, trajectory_step_, trajectory_steps_,
+      trajectory_positions_.data(), trajectory_velocities_.data());
+    trajectory_msg_.header.stamp = rclcpp::Time(now_ns, this->get_clock()->get_clock_type());
+    const size_t n = joints.size();
+    // The current setpoint already moves at the speed of the first step.
+    std::copy(joints.begin(), joints.end(), trajectory_msg_.points[0].positions.begin());
+    std::copy_n(trajectory_velocities_.begin(), n, trajectory_msg_.points[0].velocities.begin());
+    for (size_t k = 0; k < trajectory_steps_; ++k) {
+      trajectory_msgs::msg::JointTrajectoryPoint & point = trajectory_msg_.points[k + 1];
+      std::copy_n(trajectory_positions_.begin() + k * n, n, point.positions.begin());
+      std::copy_n(trajectory_velocities_.begin() + k * n, n, point.velocities.begin());
+    }
+  }
+  PerfScope scope(&perf_counters_, PerfStage::PUBLISH);
+  trajectory_pub_->publish(trajectory_msg_);
+}
+
+void TeleopTwistJoyNode::setupPipeline()
+{
+  size_t queue_size =
+    static_cast<size_t>(std::max<int64_t>(this->get_parameter("pipeline.queue_size").as_int(), 1));
+  this->get_parameter("pipeline.cpus", pipeline_cpus_);
+  pipeline_cpus_.resize(NUM_PIPELINE_STAGES, -1);
+  pipeline_input_ring_ = std::make_unique<SpscRing<PipelineInput>>(queue_size);
+  pipeline_joy_ring_ = std::make_unique<SpscRing<PipelineJoy>>(queue_size);
+  // Joint buffers are sized once, handing a command over does not allocate.
+  PipelineCommand command_prototype;
+  command_prototype.joints.resize(teleop_mapper_.joints().size());
+  pipeline_command_ring_ =
+    std::make_unique<SpscRing<PipelineCommand>>(queue_size, command_prototype);
+  for (auto & dropped : pipeline_dropped_) {
+    dropped = 0;
+  }
+  pipeline_enable_ = true;
+  pipeline_threads_[PIPELINE_DECODE] = std::thread(&TeleopTwistJoyNode::pipelineDecodeLoop, this);
+  pipeline_threads_[PIPELINE_MAPPING] =
+    std::thread(&TeleopTwistJoyNode::pipelineMappingLoop, this);
+  pipeline_threads_[PIPELINE_OUTPUT] = std::thread(&TeleopTwistJoyNode::pipelineOutputLoop, this);
+  RCLCPP_INFO(
+    this->get_logger(), "Pipeline mode with %zu slot queues.", pipeline_joy_ring_->capacity());
+}
+
+void TeleopTwistJoyNode::pipelineDecodeLoop()
+{
+  pinCurrentThread(pipeline_cpus_[PIPELINE_DECODE], this->get_logger());
+  const std::chrono::milliseconds idle_timeout(100);
+  while (rclcpp::ok() && !pipeline_stop_) {
+    if (!pipeline_input_ring_->wait(idle_timeout)) {
+      continue;
+    }
+    PipelineInput * input = pipeline_input_ring_->consumerSlot();
+    size_t depth = pipeline_input_ring_->size();
+    PipelineJoy * item = pipeline_joy_ring_->producerSlot();
+    if (item == nullptr) {
+      ++pipeline_dropped_[PIPELINE_MAPPING];
+    } else if (input->joy_msg) {
+      toJoySnapshot(*input->joy_msg, &item->joy);
+    } else {
+      const rcl_serialized_message_t & buffer =
+        input->serialized_msg->get_rcl_serialized_message();
+      if (!joy_decoder_.decode(buffer.buffer, buffer.buffer_length, &item->joy)) {
+        throttled_logger_.log(malformed_joy_log_site_);
+        item = nullptr;
+      }
+    }
+    int64_t received_ns = input->received_ns;
+    // Release the message here, not when the slot is next overwritten.
+    input->joy_msg.reset();
+    input->serialized_msg.reset();
+    pipeline_input_ring_->pop();
+
+    int64_t queued_ns = steadyNowNs();
+    if (item != nullptr) {
+      item->received_ns = received_ns;
+      item->queued_ns = queued_ns;
+      pipeline_joy_ring_->push();
+    }
+    if (statistics_enable_) {
+      std::lock_guard<std::mutex> lock(statistics_mutex_);
+      PipelineStageStats & stats = pipeline_stats_[PIPELINE_DECODE];
+      stats.latency.record(queued_ns - received_ns);
+      stats.max_queue_depth = std::max(stats.max_queue_depth, depth);
+    }
+  }
+}
+
+void TeleopTwistJoyNode::pipelineMappingLoop()
+{
+  pinCurrentThread(pipeline_cpus_[PIPELINE_MAPPING], this->get_logger());
+  const std::chrono::milliseconds idle_timeout(100);
+  while (rclcpp::ok() && !pipeline_stop_) {
+    if (!pipeline_joy_ring_->wait(idle_timeout)) {
+      continue;
+    }
+    PipelineJoy * item = pipeline_joy_ring_->consumerSlot();
+    size_t depth = pipeline_joy_ring_->size();
+    PipelineCommand * output = pipeline_command_ring_->producerSlot();
+    if (output == nullptr) {
+      ++pipeline_dropped_[PIPELINE_OUTPUT];
+    } else {
+      output->dt = mapJoy(item->joy, &output->command);
+      const std::vector<double> & positions = teleop_mapper_.joints().positions();
+      std::copy(positions.begin(), positions.end(), output->joints.begin());
+      output->joy = item->joy;
+      output->received_ns = item->received_ns;
+      output->queued_ns = steadyNowNs();
+      pipeline_command_ring_->push();
+    }
+    int64_t queued_ns = item->queued_ns;
+    if (statistics_enable_) {
+      int64_t elapsed_ns = steadyNowNs() - queued_ns;
+      std::lock_guard<std::mutex> lock(statistics_mutex_);
+      PipelineStageStats & stats = pipeline_stats_[PIPELINE_MAPPING];
+      stats.latency.record(elapsed_ns);
+      stats.max_queue_depth = std::max(stats.max_queue_depth, depth);
+    }
+    // Off the live path, the command is already with the output stage.
+    if (shadow_enable_ && output != nullptr) {
+      runShadow(item->joy, output->dt);
+    }
+    pipeline_joy_ring_->pop();
+  }
+}
+
+void TeleopTwistJoyNode::pipelineOutputLoop()
+{
+  pinCurrentThread(pipeline_cpus_[PIPELINE_OUTPUT], this->get_logger());
+  const std::chrono::milliseconds idle_timeout(100);
+  while (rclcpp::ok() && !pipeline_stop_) {
+    if (!pipeline_command_ring_->wait(idle_timeout)) {
+      continue;
+    }
+    PipelineCommand * item = pipeline_command_ring_->consumerSlot();
+    size_t depth = pipeline_command_ring_->size();
+    // Counted from the reception of the input, so "joy processing" covers all stages.
+    publishCommand(item->command, item->joints, item->joy, item->dt, item->received_ns);
+    if (statistics_enable_) {
+      int64_t elapsed_ns = steadyNowNs() - item->queued_ns;
+      std::lock_guard<std::mutex> lock(statistics_mutex_);
+      PipelineStageStats & stats = pipeline_stats_[PIPELINE_OUTPUT];
+      stats.latency.record(elapsed_ns);
+      stats.max_queue_depth = std::max(stats.max_queue_depth, depth);
+    }
+    pipeline_command_ring_->pop();
+  }
+}
+
+void TeleopTwistJoyNode::setupShadow(ParameterSource * parameters)
+{
+  // Every shadow.* mapping parameter defaults to its live value.
+  OverlayParameterSource shadow_source(parameters, "shadow.");
+  shadow_mapping_config_ = loadMappingConfig(&shadow_source, "shadow.");
+  for (const auto & warning : shadow_mapping_config_.warnings) {
+    RCLCPP_ERROR(this->get_logger(), "Shadow: %s", warning.c_str());
+  }
+  if (!shadow_mapper_.configure(shadow_mapping_config_)) {
+    RCLCPP_ERROR(
+      this->get_logger(), "Shadow joint output indices are not a permutation, using list order.");
+  }
+  shadow_joint_state_msg_.name = shadow_mapper_.joints().names();
+  shadow_joint_state_msg_.position.resize(shadow_mapper_.joints().size());
+
+  std::string ns = this->get_parameter("shadow.namespace").as_string();
+  shadow_cmd_vel_pub_ = this->create_publisher<geometry_msgs::msg::Twist>(ns + "/cmd_vel", 10);
+  shadow_joint_state_pub_ =
+    this->create_publisher<sensor_msgs::msg::JointState>(ns + "/cmd_gimbal_joint", 10);
+  shadow_shoot_pub_ = this->create_publisher<example_interfaces::msg::UInt8>(ns + "/cmd_shoot", 10);
+  shadow_enable_ = true;
+  if (joy_serialized_sub_) {
+    // The shadow reads the same partially decoded snapshot.
+    bindJoyDecoder();
+  }
+  RCLCPP_INFO(this->get_logger(), "Shadow mapping publishing below %s.", ns.c_str());
+}
+
+void TeleopTwistJoyNode::bindJoyDecoder()
+{
+  // Union of the live and the shadow bindings, anything else stays zero.
+  std::set<int64_t> axes;
+  std::set<int64_t> buttons;
+  std::vector<const MappingConfig *> configs = {&mapping_config_};
+  if (shadow_enable_) {
+    configs.push_back(&shadow_mapping_config_);
+  }
+  for (const MappingConfig * config : configs) {
+    for (const auto & axis : config->axis_chassis) {
+      axes.insert(axis.second);
+    }
+    for (const auto & axis : config->axis_gimbal) {
+      axes.insert(axis.second);
+    }
+    for (const auto & joint : config->joints) {
+      axes.insert(joint.axis);
+    }
+    buttons.insert(config->enable_button);
+    buttons.insert(config->enable_turbo_button);
+  }
+  joy_decoder_.bind(
+    std::vector<int64_t>(axes.begin(), axes.end()),
+    std::vector<int64_t>(buttons.begin(), buttons.end()));
+}
+
+void TeleopTwistJoyNode::runShadow(const JoySnapshot & joy, double dt)
+{
+  auto start = std::chrono::steady_clock::now();
+  // Same input and dt as the live mapping, published whatever the profile so
+  // both can be compared sample by sample.
+  TeleopCommand command;
+  shadow_mapper_.map(joy, dt, &command);
+
+  auto cmd_vel_msg = std::make_unique<geometry_msgs::msg::Twist>();
+  fillCmdVelMsg(command, cmd_vel_msg.get());
+  shadow_cmd_vel_pub_->publish(std::move(cmd_vel_msg));
+  shadow_joint_state_msg_.header.stamp = this->now();
+  const std::vector<double> & positions = shadow_mapper_.joints().positions();
+  std::copy(positions.begin(), positions.end(), shadow_joint_state_msg_.position.begin());
+  shadow_joint_state_pub_->publish(shadow_joint_state_msg_);
+  example_interfaces::msg::UInt8 shoot_msg;
+  shoot_msg.data = command.shoot;
+  shadow_shoot_pub_->publish(shoot_msg);
+
+  if (statistics_enable_) {
+    int64_t elapsed_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+        .count();
+    std::lock_guard<std::mutex> lock(statistics_mutex_);
+    shadow_stats_.record(elapsed_ns);
+  }
 }
 
 void TeleopTwistJoyNode::sendCmdVelMsg(
-  const sensor_msgs::msg::Joy::SharedPtr joy_msg, const std::string & which_map)
+  const TeleopCommand & command, const std::vector<double> & joints, double dt)
 {
   if (control_mode_ == "manual_control") {
-    if (publish_stamped_twist_) {
+    if (formation_enable_) {
+      sendFormationCmdVel(command, dt);
+    } else if (!outputWanted(cmd_vel_health_)) {
+      // Nobody listens, skip building the message.
+    } else if (publish_stamped_twist_) {
       auto cmd_vel_stamped_msg = std::make_unique<geometry_msgs::msg::TwistStamped>();
-      cmd_vel_stamped_msg->header.stamp = this->now();
-      cmd_vel_stamped_msg->header.frame_id = robot_base_frame_;
-      fillCmdVelMsg(joy_msg, which_map, &cmd_vel_stamped_msg->twist);
+      {
+        PerfScope scope(&perf_counters_, PerfStage::FILL);
+        cmd_vel_stamped_msg->header.stamp = this->now();
+        cmd_vel_stamped_msg->header.frame_id = robot_base_frame_;
+        fillCmdVelMsg(command, &cmd_vel_stamped_msg->twist);
+      }
+      PerfScope scope(&perf_counters_, PerfStage::PUBLISH);
+      int64_t publish_start_ns = steadyNowNs();
       cmd_vel_stamped_pub_->publish(std::move(cmd_vel_stamped_msg));
+      cmd_vel_health_.recordPublish(steadyNowNs() - publish_start_ns);
     } else {
       auto cmd_vel_msg = std::make_unique<geometry_msgs::msg::Twist>();
-      fillCmdVelMsg(joy_msg, which_map, cmd_vel_msg.get());
+      {
+        PerfScope scope(&perf_counters_, PerfStage::FILL);
+        fillCmdVelMsg(command, cmd_vel_msg.get());
+      }
+      PerfScope scope(&perf_counters_, PerfStage::PUBLISH);
+      int64_t publish_start_ns = steadyNowNs();
       cmd_vel_pub_->publish(std::move(cmd_vel_msg));
+      cmd_vel_health_.recordPublish(steadyNowNs() - publish_start_ns);
     }
   } else {
-    sendGoalPoseAction(joy_msg, which_map);
+    sendGoalPoseAction(command);
+  }
+  if (outputWanted(joint_state_health_)) {
+    {
+      PerfScope scope(&perf_counters_, PerfStage::FILL);
+      fillJointStateMsg(joints, &joint_state_msg_);
+    }
+    PerfScope scope(&perf_counters_, PerfStage::PUBLISH);
+    int64_t publish_start_ns = steadyNowNs();
+    joint_state_pub_->publish(joint_state_msg_);
+    joint_state_health_.recordPublish(steadyNowNs() - publish_start_ns);
   }
-  auto joint_state_msg = std::make_unique<sensor_msgs::msg::JointState>();
-  fillJointStateMsg(joy_msg, which_map, joint_state_msg.get());
-  joint_state_pub_->publish(std::move(joint_state_msg));
   sent_disable_msg_ = true;
 }
 
 void TeleopTwistJoyNode::fillCmdVelMsg(
-  const sensor_msgs::msg::Joy::SharedPtr joy_msg, const std::string & which_map,
-  geometry_msgs::msg::Twist * cmd_vel_msg)
+  const TeleopCommand & command, geometry_msgs::msg::Twist * cmd_vel_msg)
 {
-  double lin_x = getVal(joy_msg, axis_chassis_map_, scale_chassis_map_[which_map], "x");
-  double ang_z = getVal(joy_msg, axis_chassis_map_, scale_chassis_map_[which_map], "yaw");
-
-  cmd_vel_msg->linear.x = lin_x;
-  cmd_vel_msg->linear.y = getVal(joy_msg, axis_chassis_map_, scale_chassis_map_[which_map], "y");
-  cmd_vel_msg->linear.z = getVal(joy_msg, axis_chassis_map_, scale_chassis_map_[which_map], "z");
-  cmd_vel_msg->angular.z = (lin_x < 0.0 && inverted_reverse_) ? -ang_z : ang_z;
-  cmd_vel_msg->angular.y =
-    getVal(joy_msg, axis_chassis_map_, scale_chassis_map_[which_map], "pitch");
-  cmd_vel_msg->angular.x =
-    getVal(joy_msg, axis_chassis_map_, scale_chassis_map_[which_map], "roll");
+  cmd_vel_msg->linear.x = command.chassis[LINEAR_X];
+  cmd_vel_msg->linear.y = command.chassis[LINEAR_Y];
+  cmd_vel_msg->linear.z = command.chassis[LINEAR_Z];
+  cmd_vel_msg->angular.x = command.chassis[ANGULAR_X];
+  cmd_vel_msg->angular.y = command.chassis[ANGULAR_Y];
+  cmd_vel_msg->angular.z = command.chassis[ANGULAR_Z];
 }
 
 void TeleopTwistJoyNode::fillJointStateMsg(
-  const sensor_msgs::msg::Joy::SharedPtr joy_msg, const std::string & which_map,
-  sensor_msgs::msg::JointState * joint_state_msg)
+  const std::vector<double> & joints, sensor_msgs::msg::JointState * joint_state_msg)
 {
-  static double pitch = 0.0;
-  static double yaw = 0.0;
-
-  pitch += getVal(joy_msg, axis_gimbal_map_, scale_gimbal_map_[which_map], "pitch") * dt_;
-  yaw += getVal(joy_msg, axis_gimbal_map_, scale_gimbal_map_[which_map], "yaw") * dt_;
-
   joint_state_msg->header.stamp = this->now();
-  joint_state_msg->name = {"gimbal_pitch_joint", "gimbal_yaw_joint"};
-  joint_state_msg->position = {pitch, yaw};
+  std::copy(joints.begin(), joints.end(), joint_state_msg->position.begin());
 }
 
-void TeleopTwistJoyNode::sendGoalPoseAction(
-  const sensor_msgs::msg::Joy::SharedPtr joy_msg, const std::string & which_map)
+void TeleopTwistJoyNode::sendGoalPoseAction(const TeleopCommand & command)
 {
-  double x = getVal(joy_msg, axis_chassis_map_, scale_chassis_map_[which_map], "x");
-  double y = getVal(joy_msg, axis_chassis_map_, scale_chassis_map_[which_map], "y");
+  double x = command.chassis[LINEAR_X];
+  double y = command.chassis[LINEAR_Y];
   if (abs(x) <= 0.1 && abs(y) <= 0.1) {
     sent_disable_msg_ = true;
     return;
@@ -232,20 +1343,64 @@ void TeleopTwistJoyNode::sendGoalPoseAction(
   goal.pose.header.frame_id = "map";
 
   try {
+    PerfScope scope(&perf_counters_, PerfStage::TF);
     auto transform = tf_buffer_->lookupTransform("map", robot_base_frame_, tf2::TimePointZero);
     tf2::doTransform(gimbal_pose, goal.pose, transform);
   } catch (tf2::TransformException & ex) {
-    RCLCPP_WARN(
-      this->get_logger(), "Failed to transform goal pose from %s to map: %s",
-      robot_base_frame_.c_str(), ex.what());
+    throttled_logger_.log(tf_failure_log_site_, robot_base_frame_.c_str(), ex.what());
     return;
   }
-  static auto last_goal_time = this->now();
   auto current_time = this->now();
-  if ((current_time - last_goal_time).seconds() >= 0.25) {
+  // Also restarts after a backwards clock jump.
+  if (current_time < last_goal_time_ || (current_time - last_goal_time_).seconds() >= 0.25) {
+    if (goal_snap_enable_) {
+      bool reachable;
+      {
+        std::lock_guard<std::mutex> lock(costmap_mutex_);
+        // Goals pass unchanged until the first costmap arrives.
+        reachable = costmap_cache_.snapToFree(
+          &goal.pose.pose.position.x, &goal.pose.pose.position.y,
+          static_cast<int>(goal_snap_occupied_threshold_), goal_snap_max_distance_,
+          goal_snap_allow_unknown_);
+      }
+      if (!reachable) {
+        throttled_logger_.log(goal_blocked_log_site_);
+        return;
+      }
+    }
+    PerfScope scope(&perf_counters_, PerfStage::GOAL);
     auto goal_handle_future = nav_to_pose_client_->async_send_goal(goal);
-    last_goal_time = current_time;
+    last_goal_time_ = current_time;
+  }
+}
+
+void TeleopTwistJoyNode::costmapCallback(const nav_msgs::msg::OccupancyGrid::SharedPtr costmap_msg)
+{
+  if (costmap_msg->header.frame_id != "map") {
+    RCLCPP_WARN_ONCE(
+      this->get_logger(), "Costmap in frame %s, not map, goals are not snapped.",
+      costmap_msg->header.frame_id.c_str());
+    return;
   }
+  const nav_msgs::msg::MapMetaData & info = costmap_msg->info;
+  // Copied outside the lock, then moved in.
+  CostmapCache costmap;
+  costmap.setMap(
+    info.resolution, info.origin.position.x, info.origin.position.y, info.width, info.height,
+    costmap_msg->data);
+  std::lock_guard<std::mutex> lock(costmap_mutex_);
+  costmap_cache_ = std::move(costmap);
+}
+
+void TeleopTwistJoyNode::costmapUpdateCallback(
+  const map_msgs::msg::OccupancyGridUpdate::SharedPtr update_msg)
+{
+  // Only the window is copied, in place. Updates before the first full map or
+  // outside it are dropped by update().
+  std::lock_guard<std::mutex> lock(costmap_mutex_);
+  costmap_cache_.update(
+    static_cast<uint32_t>(update_msg->x), static_cast<uint32_t>(update_msg->y),
+    update_msg->width, update_msg->height, update_msg->data);
 }
 
 void TeleopTwistJoyNode::sendZeroCommand()
@@ -253,6 +1408,11 @@ void TeleopTwistJoyNode::sendZeroCommand()
   if (control_mode_ == "auto_control") {
     auto goal_handle_future = nav_to_pose_client_->async_cancel_goals_before(this->now());
   }
+  if (formation_enable_) {
+    stopFormation();
+    return;
+  }
+  // Never skipped, a subscriber may have matched since the last health poll.
   if (publish_stamped_twist_) {
     auto cmd_vel_stamped_msg = std::make_unique<geometry_msgs::msg::TwistStamped>();
     cmd_vel_stamped_msg->header.stamp = this->now();
@@ -263,6 +1423,261 @@ void TeleopTwistJoyNode::sendZeroCommand()
     cmd_vel_pub_->publish(std::move(cmd_vel_msg));
   }
 }
+
+void TeleopTwistJoyNode::setupFormation()
+{
+  std::vector<std::string> robots = this->get_parameter("formation.robots").as_string_array();
+  std::vector<double> offsets = this->get_parameter("formation.offsets").as_double_array();
+  if (robots.empty() || offsets.size() != 3 * robots.size()) {
+    RCLCPP_ERROR(
+      this->get_logger(),
+      "Formation needs an x, y, yaw offset for each of the %zu robots, got %zu values. Formation "
+      "disabled.",
+      robots.size(), offsets.size());
+    return;
+  }
+
+  std::vector<FormationSlot> slots(robots.size());
+  for (size_t i = 0; i < robots.size(); ++i) {
+    slots[i].x = offsets[3 * i];
+    slots[i].y = offsets[3 * i + 1];
+    slots[i].yaw = offsets[3 * i + 2];
+  }
+  formation_solver_.configure(
+    slots, this->get_parameter("formation.position_gain").as_double(),
+    this->get_parameter("formation.yaw_gain").as_double(),
+    this->get_parameter("formation.max_linear_correction").as_double(),
+    this->get_parameter("formation.max_angular_correction").as_double());
+  formation_pose_timeout_ns_ =
+    static_cast<int64_t>(this->get_parameter("formation.pose_timeout").as_double() * 1e9);
+
+  std::string pose_topic = this->get_parameter("formation.pose_topic").as_string();
+  std::string cmd_vel_topic = this->get_parameter("formation.cmd_vel_topic").as_string();
+  for (size_t i = 0; i < robots.size(); ++i) {
+    formation_cmd_vel_pubs_.push_back(
+      this->create_publisher<geometry_msgs::msg::Twist>(robots[i] + "/" + cmd_vel_topic, 10));
+    formation_pose_subs_.push_back(this->create_subscription<geometry_msgs::msg::PoseStamped>(
+      robots[i] + "/" + pose_topic, rclcpp::SensorDataQoS(),
+      [this, i](const geometry_msgs::msg::PoseStamped::SharedPtr pose_msg) {
+        formationPoseCallback(i, pose_msg);
+      }));
+    RCLCPP_INFO(
+      this->get_logger(), "Formation robot %s at (%f, %f, %f).", robots[i].c_str(), slots[i].x,
+      slots[i].y, slots[i].yaw);
+  }
+  formation_enable_ = true;
+}
+
+void TeleopTwistJoyNode::formationPoseCallback(
+  size_t robot, const geometry_msgs::msg::PoseStamped::SharedPtr pose_msg)
+{
+  // Freshness is judged on arrival, robot clocks need not agree with ours.
+  std::lock_guard<std::mutex> lock(formation_mutex_);
+  formation_solver_.setPose(
+    robot, pose_msg->pose.position.x, pose_msg->pose.position.y,
+    tf2::getYaw(pose_msg->pose.orientation), this->now().nanoseconds());
+}
+
+void TeleopTwistJoyNode::sendFormationCmdVel(const TeleopCommand & command, double dt)
+{
+  std::lock_guard<std::mutex> lock(formation_mutex_);
+  {
+    PerfScope scope(&perf_counters_, PerfStage::MAPPING);
+    formation_solver_.solve(
+      command.chassis[LINEAR_X], command.chassis[LINEAR_Y], command.chassis[ANGULAR_Z], dt,
+      this->now().nanoseconds(), formation_pose_timeout_ns_);
+  }
+  PerfScope scope(&perf_counters_, PerfStage::PUBLISH);
+  for (size_t i = 0; i < formation_cmd_vel_pubs_.size(); ++i) {
+    auto cmd_vel_msg = std::make_unique<geometry_msgs::msg::Twist>();
+    cmd_vel_msg->linear.x = formation_solver_.linearX()[i];
+    cmd_vel_msg->linear.y = formation_solver_.linearY()[i];
+    cmd_vel_msg->angular.z = formation_solver_.angularZ()[i];
+    formation_cmd_vel_pubs_[i]->publish(std::move(cmd_vel_msg));
+  }
+}
+
+void TeleopTwistJoyNode::stopFormation()
+{
+  std::lock_guard<std::mutex> lock(formation_mutex_);
+  // The formation is re-anchored on wherever the robots stopped.
+  formation_solver_.reset();
+  for (const auto & cmd_vel_pub : formation_cmd_vel_pubs_) {
+    cmd_vel_pub->publish(geometry_msgs::msg::Twist());
+  }
+}
+
+bool TeleopTwistJoyNode::outputWanted(const PublisherHealth & health) const
+{
+  return !skip_unsubscribed_outputs_ || health.hasSubscribers();
+}
+
+void TeleopTwistJoyNode::publishStatistics()
+{
+  DurationHistogram callback_stats;
+  uint64_t callback_over_budget = 0;
+  DurationHistogram input_latency_stats;
+  uint64_t input_latency_over_budget = 0;
+  DurationHistogram shadow_stats;
+  PipelineStageStats pipeline_stats[NUM_PIPELINE_STAGES];
+  {
+    std::lock_guard<std::mutex> lock(statistics_mutex_);
+    for (size_t stage = 0; stage < NUM_PIPELINE_STAGES; ++stage) {
+      pipeline_stats[stage] = pipeline_stats_[stage];
+      pipeline_stats_[stage] = PipelineStageStats();
+    }
+    callback_stats = callback_stats_;
+    callback_over_budget = callback_over_budget_;
+    callback_stats_.reset();
+    callback_over_budget_ = 0;
+    input_latency_stats = input_latency_stats_;
+    input_latency_over_budget = input_latency_over_budget_;
+    input_latency_stats_.reset();
+    input_latency_over_budget_ = 0;
+    shadow_stats = shadow_stats_;
+    shadow_stats_.reset();
+  }
+
+  double window = this->get_parameter("statistics.period").as_double();
+  auto diagnostics_msg = std::make_unique<diagnostic_msgs::msg::DiagnosticArray>();
+  diagnostics_msg->header.stamp = this->now();
+  diagnostics_msg->status.push_back(makeDurationStatus(
+    std::string(this->get_name()) + ": joy processing", callback_stats, callback_budget_ns_,
+    callback_over_budget, window));
+  diagnostics_msg->status.push_back(makeDurationStatus(
+    std::string(this->get_name()) + ": joy stamp to command latency", input_latency_stats,
+    latency_budget_ns_, input_latency_over_budget, window));
+  if (shadow_enable_) {
+    diagnostics_msg->status.push_back(makeDurationStatus(
+      std::string(this->get_name()) + ": shadow mapping", shadow_stats, 0, 0, window));
+  }
+  if (pipeline_enable_) {
+    static const char * STAGE_NAMES[NUM_PIPELINE_STAGES] = {"decode", "mapping", "output"};
+    const size_t queue_depths[NUM_PIPELINE_STAGES] = {
+      pipeline_input_ring_->size(), pipeline_joy_ring_->size(), pipeline_command_ring_->size()};
+    for (size_t stage = 0; stage < NUM_PIPELINE_STAGES; ++stage) {
+      diagnostic_msgs::msg::DiagnosticStatus status = makeDurationStatus(
+        std::string(this->get_name()) + ": pipeline " + STAGE_NAMES[stage],
+        pipeline_stats[stage].latency, 0, 0, window);
+      addValue(&status, "queue_depth", static_cast<double>(queue_depths[stage]));
+      addValue(
+        &status, "max_queue_depth", static_cast<double>(pipeline_stats[stage].max_queue_depth));
+      addValue(&status, "dropped", static_cast<double>(pipeline_dropped_[stage].load()));
+      diagnostics_msg->status.push_back(status);
+    }
+  }
+  if (this->get_parameter("statistics.hardware_counters").as_bool()) {
+    diagnostics_msg->status.push_back(makePerfStatus(
+      std::string(this->get_name()) + ": hardware counters", perf_counters_));
+  }
+  diagnostics_msg->status.push_back(makeBackpressureStatus(
+    std::string(this->get_name()) + ": output backpressure",
+    {&cmd_vel_health_, &joint_state_health_, &shoot_health_}));
+  if (power_governor_enable_) {
+    diagnostic_msgs::msg::DiagnosticStatus status;
+    status.name = std::string(this->get_name()) + ": power governor";
+    status.hardware_id = "pb_teleop_twist_joy";
+    int64_t now_ns = this->now().nanoseconds();
+    std::lock_guard<std::mutex> lock(power_governor_mutex_);
+    if (!power_governor_.powerFresh(now_ns) || !power_governor_.bufferFresh(now_ns)) {
+      status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+      status.message = "referee telemetry stale";
+    } else {
+      status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
+      status.message = "OK";
+    }
+    addValue(&status, "limit_w", power_governor_.limit());
+    addValue(&status, "buffer_j", power_governor_.buffer());
+    addValue(&status, "budget_w", power_governor_.budget());
+    addValue(&status, "predicted_power_w", power_governor_.predictedPower());
+    addValue(&status, "correction", power_governor_.correction());
+    addValue(&status, "min_scale", power_governor_min_scale_);
+    power_governor_min_scale_ = 1.0;
+    diagnostics_msg->status.push_back(status);
+  }
+  diagnostics_pub_->publish(std::move(diagnostics_msg));
+}
+
+void TeleopTwistJoyNode::setupPowerGovernor()
+{
+  // Goals and formation twists do not drive this chassis directly.
+  if (control_mode_ != "manual_control" || formation_enable_) {
+    RCLCPP_ERROR(
+      this->get_logger(),
+      "Power governor needs manual_control without formation. Power governor disabled.");
+    return;
+  }
+  std::vector<double> linear =
+    this->get_parameter("power_governor.linear_coefficients").as_double_array();
+  std::vector<double> quadratic =
+    this->get_parameter("power_governor.quadratic_coefficients").as_double_array();
+  double buffer_horizon = this->get_parameter("power_governor.buffer_horizon").as_double();
+  if (linear.size() != 3 || quadratic.size() != 3 || buffer_horizon <= 0.0) {
+    RCLCPP_ERROR(
+      this->get_logger(),
+      "Power governor needs 3 linear and 3 quadratic coefficients, got %zu and %zu, and a "
+      "positive buffer_horizon. Power governor disabled.",
+      linear.size(), quadratic.size());
+    return;
+  }
+
+  PowerGovernorConfig config;
+  config.static_power = this->get_parameter("power_governor.static_power").as_double();
+  std::copy(linear.begin(), linear.end(), config.linear_coefficients);
+  std::copy(quadratic.begin(), quadratic.end(), config.quadratic_coefficients);
+  config.default_limit = this->get_parameter("power_governor.default_limit").as_double();
+  config.buffer_reserve = this->get_parameter("power_governor.buffer_reserve").as_double();
+  config.buffer_horizon = buffer_horizon;
+  config.telemetry_timeout_ns = static_cast<int64_t>(
+    this->get_parameter("power_governor.telemetry_timeout").as_double() * 1e9);
+  config.correction_rate = this->get_parameter("power_governor.correction_rate").as_double();
+  power_governor_.configure(config);
+
+  // Best effort matches referee bridges publishing either way.
+  chassis_power_sub_ = this->create_subscription<example_interfaces::msg::Float64>(
+    this->get_parameter("power_governor.power_topic").as_string(), rclcpp::SensorDataQoS(),
+    [this](const example_interfaces::msg::Float64::SharedPtr msg) {
+      std::lock_guard<std::mutex> lock(power_governor_mutex_);
+      power_governor_.setPower(msg->data, this->now().nanoseconds());
+    });
+  buffer_energy_sub_ = this->create_subscription<example_interfaces::msg::Float64>(
+    this->get_parameter("power_governor.buffer_topic").as_string(), rclcpp::SensorDataQoS(),
+    [this](const example_interfaces::msg::Float64::SharedPtr msg) {
+      std::lock_guard<std::mutex> lock(power_governor_mutex_);
+      power_governor_.setBuffer(msg->data, this->now().nanoseconds());
+    });
+  power_limit_sub_ = this->create_subscription<example_interfaces::msg::Float64>(
+    this->get_parameter("power_governor.limit_topic").as_string(), rclcpp::SensorDataQoS(),
+    [this](const example_interfaces::msg::Float64::SharedPtr msg) {
+      std::lock_guard<std::mutex> lock(power_governor_mutex_);
+      power_governor_.setLimit(msg->data);
+    });
+  power_governor_enable_ = true;
+  RCLCPP_INFO(
+    this->get_logger(), "Power governor on, %.1f W until the referee sends a limit.",
+    config.default_limit);
+}
+
+void TeleopTwistJoyNode::governChassisPower(TeleopCommand * command)
+{
+  PerfScope scope(&perf_counters_, PerfStage::FILL);
+  std::lock_guard<std::mutex> lock(power_governor_mutex_);
+  double scale = power_governor_.govern(
+    &command->chassis[LINEAR_X], &command->chassis[LINEAR_Y], &command->chassis[ANGULAR_Z],
+    this->now().nanoseconds());
+  power_governor_min_scale_ = std::min(power_governor_min_scale_, scale);
+}
+
+void TeleopTwistJoyNode::pollPublisherHealth()
+{
+  if (publish_stamped_twist_) {
+    cmd_vel_health_.poll(*cmd_vel_stamped_pub_, this->get_logger());
+  } else {
+    cmd_vel_health_.poll(*cmd_vel_pub_, this->get_logger());
+  }
+  joint_state_health_.poll(*joint_state_pub_, this->get_logger());
+  shoot_health_.poll(*shoot_pub_, this->get_logger());
+}
 }  // namespace pb_teleop_twist_joy
 
 #include <rclcpp_components/register_node_macro.hpp>
@@ -0,0 +1,166 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pb_teleop_twist_joy/perf_counters.hpp"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+int perfEventOpen(perf_event_attr * attr, int group_fd)
+{
+  // Current thread, any CPU.
+  return static_cast<int>(syscall(SYS_perf_event_open, attr, 0, -1, group_fd, 0));
+}
+
+const uint64_t EVENT_CONFIGS[NUM_PERF_EVENTS] = {
+  PERF_COUNT_HW_CPU_CYCLES,
+  PERF_COUNT_HW_INSTRUCTIONS,
+  PERF_COUNT_HW_CACHE_MISSES,
+  PERF_COUNT_HW_BRANCH_MISSES,
+};
+}  // namespace
+
+const char * perfStageName(PerfStage stage)
+{
+  switch (stage) {
+    case PerfStage::TOTAL:
+      return "total";
+    case PerfStage::MAPPING:
+      return "mapping";
+    case PerfStage::FILL:
+      return "message fill";
+    case PerfStage::PUBLISH:
+      return "publish";
+    case PerfStage::TF:
+      return "tf";
+    case PerfStage::GOAL:
+      return "goal send";
+  }
+  return "unknown";
+}
+
+PerfCounters::PerfCounters() : enabled_(false), opened_(false), failed_(false), num_opened_(0)
+{
+  for (size_t i = 0; i < NUM_PERF_EVENTS; ++i) {
+    fds_[i] = -1;
+    slot_[i] = -1;
+  }
+}
+
+PerfCounters::~PerfCounters()
+{
+  for (int fd : fds_) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+}
+
+bool PerfCounters::open()
+{
+  int leader = -1;
+  for (size_t i = 0; i < NUM_PERF_EVENTS; ++i) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = EVENT_CONFIGS[i];
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.disabled = leader < 0 ? 1 : 0;
+    int fd = perfEventOpen(&attr, leader);
+    if (fd < 0) {
+      if (leader < 0) {
+        // Without cycles there is no group to hang the rest on.
+        error_ = std::string("perf_event_open: ") + std::strerror(errno);
+        return false;
+      }
+      // Some cores lack a counter (e.g. cache misses), count the others.
+      continue;
+    }
+    if (leader < 0) {
+      leader = fd;
+    }
+    fds_[i] = fd;
+    slot_[i] = static_cast<int>(num_opened_++);
+  }
+  ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  return true;
+}
+
+bool PerfCounters::read(PerfReading * reading)
+{
+  uint64_t buffer[1 + NUM_PERF_EVENTS];
+  ssize_t expected = static_cast<ssize_t>((1 + num_opened_) * sizeof(uint64_t));
+  if (::read(fds_[PERF_CYCLES], buffer, sizeof(buffer)) != expected) {
+    return false;
+  }
+  for (size_t i = 0; i < NUM_PERF_EVENTS; ++i) {
+    reading->values[i] = slot_[i] < 0 ? 0 : buffer[1 + slot_[i]];
+  }
+  return true;
+}
+
+bool PerfCounters::begin(PerfReading * reading)
+{
+  if (!enabled_ || failed_) {
+    return false;
+  }
+  if (!opened_) {
+    opened_ = true;
+    failed_ = !open();
+    if (failed_) {
+      return false;
+    }
+  }
+  return read(reading);
+}
+
+void PerfCounters::end(PerfStage stage, const PerfReading & begin_reading)
+{
+  PerfReading end_reading;
+  if (!read(&end_reading)) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  PerfStageTotals & totals = totals_[static_cast<size_t>(stage)];
+  ++totals.runs;
+  for (size_t i = 0; i < NUM_PERF_EVENTS; ++i) {
+    totals.values[i] += end_reading.values[i] - begin_reading.values[i];
+    totals.counted[i] = slot_[i] >= 0;
+  }
+}
+
+void PerfCounters::collect(PerfStageTotals * totals)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t i = 0; i < NUM_PERF_STAGES; ++i) {
+    totals[i] = totals_[i];
+    totals_[i] = PerfStageTotals();
+  }
+}
+
+}  // namespace pb_teleop_twist_joy
@@ -0,0 +1,125 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pb_teleop_twist_joy/phase_lock.hpp"
+
+#include <algorithm>
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+// Loop gains of the second order tracking filter. The phase gain is high enough
+// to follow a controller that restarts, the period gain is kept small so that
+// jitter in the tick stamps does not leak into the output period.
+constexpr double PHASE_GAIN = 0.25;
+constexpr double PERIOD_GAIN = 0.02;
+
+int64_t floorDiv(int64_t a, int64_t b)
+{
+  int64_t q = a / b;
+  return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+}  // namespace
+
+PhaseLock::PhaseLock(int64_t period_ns, int64_t offset_ns, int64_t divider)
+: nominal_period_ns_(std::max<int64_t>(period_ns, 1)),
+  offset_ns_(offset_ns),
+  divider_(std::max<int64_t>(divider, 1)),
+  has_tick_(false),
+  tick_ns_(0),
+  period_ns_(nominal_period_ns_),
+  next_target_ns_(0),
+  last_publish_ns_(0),
+  resets_(0)
+{
+}
+
+bool PhaseLock::onTick(int64_t tick_ns, int64_t * phase_error_ns)
+{
+  if (has_tick_ && tick_ns < tick_ns_ - period_ns_) {
+    // The ticks jumped backwards, the controller or the clock was restarted.
+    reset();
+  }
+  if (!has_tick_) {
+    has_tick_ = true;
+    tick_ns_ = tick_ns;
+    // Drop the free running schedule so the next target snaps onto the ticks.
+    next_target_ns_ = 0;
+    return false;
+  }
+
+  int64_t cycles = (tick_ns - tick_ns_ + period_ns_ / 2) / period_ns_;
+  if (cycles < 1) {
+    // Duplicate or reordered tick.
+    return false;
+  }
+  int64_t predicted = tick_ns_ + cycles * period_ns_;
+  double error = static_cast<double>(tick_ns - predicted);
+  tick_ns_ = predicted + static_cast<int64_t>(PHASE_GAIN * error);
+  period_ns_ += static_cast<int64_t>(PERIOD_GAIN * error / static_cast<double>(cycles));
+  period_ns_ =
+    std::min(std::max(period_ns_, nominal_period_ns_ * 9 / 10), nominal_period_ns_ * 11 / 10);
+
+  // The publish belongs to this tick when it happened within the last period.
+  if (
+    last_publish_ns_ != 0 && tick_ns >= last_publish_ns_ &&
+    tick_ns - last_publish_ns_ < period_ns_) {
+    *phase_error_ns = (tick_ns - last_publish_ns_) - offset_ns_;
+    return true;
+  }
+  return false;
+}
+
+int64_t PhaseLock::nextSampleAfter(int64_t t_ns) const
+{
+  return tick_ns_ + (floorDiv(t_ns - tick_ns_, period_ns_) + 1) * period_ns_;
+}
+
+int64_t PhaseLock::nextPublishTime(int64_t now_ns)
+{
+  if (!has_tick_) {
+    // Nothing to lock onto yet, free run at the output period.
+    if (next_target_ns_ <= now_ns) {
+      next_target_ns_ = now_ns + period_ns_ * divider_;
+    }
+    return next_target_ns_;
+  }
+
+  if (next_target_ns_ == 0) {
+    next_target_ns_ = nextSampleAfter(now_ns + offset_ns_) - offset_ns_;
+  } else if (next_target_ns_ <= now_ns) {
+    // Snap the nominal next slot onto the nearest sample of the current estimate.
+    int64_t nominal = next_target_ns_ + offset_ns_ + divider_ * period_ns_;
+    next_target_ns_ = nextSampleAfter(nominal - period_ns_ / 2) - offset_ns_;
+    if (next_target_ns_ <= now_ns) {
+      // Overran more than an output period, skip to the next reachable sample.
+      next_target_ns_ = nextSampleAfter(now_ns + offset_ns_) - offset_ns_;
+    }
+  }
+  return next_target_ns_;
+}
+
+void PhaseLock::notePublished(int64_t publish_ns) { last_publish_ns_ = publish_ns; }
+
+void PhaseLock::reset()
+{
+  has_tick_ = false;
+  next_target_ns_ = 0;
+  last_publish_ns_ = 0;
+  ++resets_;
+}
+
+}  // namespace pb_teleop_twist_joy
@@ -0,0 +1,110 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pb_teleop_twist_joy/power_governor.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pb_teleop_twist_joy
+{
+
+void PowerGovernor::configure(const PowerGovernorConfig & config)
+{
+  config_ = config;
+  correction_ = 1.0;
+  limit_ = config.default_limit;
+  power_ns_ = 0;
+  buffer_ns_ = 0;
+  budget_ = config.default_limit;
+  predicted_power_ = config.static_power;
+  governed_ns_ = 0;
+}
+
+void PowerGovernor::setPower(double power, int64_t now_ns)
+{
+  power_ns_ = now_ns;
+  // Near standstill the samples are mostly noise. Without a recent governed
+  // twist the prediction is stale and says nothing about the sample.
+  if (
+    config_.correction_rate <= 0.0 || !std::isfinite(power) || predicted_power_ < 1.0 ||
+    !fresh(governed_ns_, now_ns)) {
+    return;
+  }
+  double ratio = power / predicted_power_;
+  correction_ += config_.correction_rate * (ratio - correction_);
+  correction_ = std::min(std::max(correction_, config_.min_correction), config_.max_correction);
+}
+
+void PowerGovernor::setBuffer(double energy, int64_t now_ns)
+{
+  if (std::isfinite(energy)) {
+    buffer_ = energy;
+    buffer_ns_ = now_ns;
+  }
+}
+
+void PowerGovernor::setLimit(double limit)
+{
+  if (std::isfinite(limit) && limit > 0.0) {
+    limit_ = limit;
+  }
+}
+
+double PowerGovernor::govern(
+  double * linear_x, double * linear_y, double * angular_z, int64_t now_ns)
+{
+  // A limit once received stays, the referee only changes it on level ups.
+  budget_ = limit_;
+  if (fresh(buffer_ns_, now_ns)) {
+    budget_ += (buffer_ - config_.buffer_reserve) / config_.buffer_horizon;
+  }
+  budget_ = std::max(budget_, 0.0);
+
+  // Model power at scale s: static + s * a + s^2 * b, times the correction.
+  double * velocities[3] = {linear_x, linear_y, angular_z};
+  double a = 0.0;
+  double b = 0.0;
+  for (size_t i = 0; i < 3; ++i) {
+    double v = *velocities[i];
+    a += config_.linear_coefficients[i] * std::abs(v);
+    b += config_.quadratic_coefficients[i] * v * v;
+  }
+  double c = budget_ / correction_ - config_.static_power;
+  double scale = 1.0;
+  if (config_.static_power + a + b > budget_ / correction_) {
+    if (c <= 0.0) {
+      scale = 0.0;
+    } else if (b > 0.0) {
+      // Positive root of b s^2 + a s - c.
+      scale = 2.0 * c / (a + std::sqrt(a * a + 4.0 * b * c));
+    } else {
+      scale = c / a;
+    }
+  }
+  for (double * velocity : velocities) {
+    *velocity *= scale;
+  }
+  predicted_power_ = config_.static_power + scale * a + scale * scale * b;
+  governed_ns_ = now_ns;
+  return scale;
+}
+
+void PowerGovernor::release()
+{
+  predicted_power_ = config_.static_power;
+  governed_ns_ = 0;
+}
+
+}  // namespace pb_teleop_twist_joy
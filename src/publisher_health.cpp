@@ -0,0 +1,143 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pb_teleop_twist_joy/publisher_health.hpp"
+
+#include <cinttypes>
+
+namespace pb_teleop_twist_joy
+{
+
+PublisherHealth::PublisherHealth(const std::string & topic)
+: topic_(topic),
+  // Assume a listener until the first poll so nothing is dropped at startup.
+  subscription_count_(1),
+  deadline_missed_(0),
+  liveliness_lost_(0),
+  incompatible_qos_(0),
+  incompatible_policy_(0),
+  slow_publish_ns_(0),
+  publishes_(0),
+  slow_publishes_(0),
+  max_publish_ns_(0),
+  window_publishes_(0),
+  window_slow_publishes_(0),
+  window_max_publish_ns_(0),
+  polled_(false),
+  reported_deadline_missed_(0),
+  reported_liveliness_lost_(0),
+  reported_incompatible_qos_(0),
+  reported_publishes_(0),
+  reported_slow_publishes_(0)
+{
+}
+
+rclcpp::PublisherOptions PublisherHealth::makeOptions()
+{
+  rclcpp::PublisherOptions options;
+  options.event_callbacks.deadline_callback = [this](rclcpp::QOSDeadlineOfferedInfo & info) {
+    deadline_missed_.store(info.total_count, std::memory_order_relaxed);
+  };
+  options.event_callbacks.liveliness_callback = [this](rclcpp::QOSLivelinessLostInfo & info) {
+    liveliness_lost_.store(info.total_count, std::memory_order_relaxed);
+  };
+  options.event_callbacks.incompatible_qos_callback =
+    [this](rclcpp::QOSOfferedIncompatibleQoSInfo & info) {
+      incompatible_policy_.store(info.last_policy_kind, std::memory_order_relaxed);
+      incompatible_qos_.store(info.total_count, std::memory_order_relaxed);
+    };
+  return options;
+}
+
+void PublisherHealth::recordPublish(int64_t duration_ns)
+{
+  publishes_.fetch_add(1, std::memory_order_relaxed);
+  if (slow_publish_ns_ > 0 && duration_ns > slow_publish_ns_) {
+    slow_publishes_.fetch_add(1, std::memory_order_relaxed);
+  }
+  int64_t max_ns = max_publish_ns_.load(std::memory_order_relaxed);
+  while (duration_ns > max_ns) {
+    if (max_publish_ns_.compare_exchange_weak(max_ns, duration_ns, std::memory_order_relaxed)) {
+      break;
+    }
+  }
+}
+
+void PublisherHealth::poll(const rclcpp::PublisherBase & publisher, const rclcpp::Logger & logger)
+{
+  // Humble publishers have no matched event, consumers coming and going show
+  // up as changes of the matched count.
+  size_t count = publisher.get_subscription_count();
+  size_t previous = subscription_count_.exchange(count, std::memory_order_relaxed);
+  if (!polled_) {
+    // The count before the first poll is only assumed.
+    polled_ = true;
+    RCLCPP_INFO(logger, "%s has %zu subscription(s).", topic_.c_str(), count);
+  } else if (count < previous) {
+    RCLCPP_WARN(
+      logger, "%s lost %zu subscription(s), %zu left%s.", topic_.c_str(), previous - count, count,
+      count == 0 ? ", nobody receives it" : "");
+  } else if (count > previous) {
+    RCLCPP_INFO(logger, "%s has %zu subscription(s).", topic_.c_str(), count);
+  }
+
+  uint64_t publishes = publishes_.load(std::memory_order_relaxed);
+  uint64_t slow_publishes = slow_publishes_.load(std::memory_order_relaxed);
+  int64_t max_publish_ns = max_publish_ns_.exchange(0, std::memory_order_relaxed);
+  window_publishes_.store(publishes - reported_publishes_, std::memory_order_relaxed);
+  window_slow_publishes_.store(
+    slow_publishes - reported_slow_publishes_, std::memory_order_relaxed);
+  window_max_publish_ns_.store(max_publish_ns, std::memory_order_relaxed);
+  if (slow_publishes != reported_slow_publishes_) {
+    RCLCPP_WARN(
+      logger,
+      "%s: %" PRIu64 " of %" PRIu64 " publish(es) took over %.2f ms since last check, max %.2f "
+      "ms, a subscriber is not keeping up.",
+      topic_.c_str(), slow_publishes - reported_slow_publishes_, publishes - reported_publishes_,
+      static_cast<double>(slow_publish_ns_) * 1e-6, static_cast<double>(max_publish_ns) * 1e-6);
+  }
+  reported_publishes_ = publishes;
+  reported_slow_publishes_ = slow_publishes;
+
+  // Offered deadlines are missed by this publisher, e.g. whenever the enable
+  // button is released, so they say nothing about consumers.
+  uint64_t deadline_missed = deadline_missed_.load(std::memory_order_relaxed);
+  if (deadline_missed != reported_deadline_missed_) {
+    RCLCPP_INFO(
+      logger, "Publish deadline of %s missed %" PRIu64 " time(s) since last check.",
+      topic_.c_str(), deadline_missed - reported_deadline_missed_);
+    reported_deadline_missed_ = deadline_missed;
+  }
+
+  uint64_t liveliness_lost = liveliness_lost_.load(std::memory_order_relaxed);
+  if (liveliness_lost != reported_liveliness_lost_) {
+    RCLCPP_WARN(
+      logger, "Liveliness of %s lost %" PRIu64 " time(s) since last check.", topic_.c_str(),
+      liveliness_lost - reported_liveliness_lost_);
+    reported_liveliness_lost_ = liveliness_lost;
+  }
+
+  uint64_t incompatible_qos = incompatible_qos_.load(std::memory_order_relaxed);
+  if (incompatible_qos != reported_incompatible_qos_) {
+    RCLCPP_WARN(
+      logger,
+      "%s offered QoS incompatible with %" PRIu64 " subscription(s), policy %d, they receive "
+      "nothing.",
+      topic_.c_str(), incompatible_qos - reported_incompatible_qos_,
+      incompatible_policy_.load(std::memory_order_relaxed));
+    reported_incompatible_qos_ = incompatible_qos;
+  }
+}
+
+}  // namespace pb_teleop_twist_joy
@@ -0,0 +1,195 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pb_teleop_twist_joy/rc_frame_decoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace pb_teleop_twist_joy
+{
+
+constexpr size_t RcFrameDecoder::MAX_FRAME_SIZE;
+constexpr uint32_t RcFrameDecoder::MAX_LOST_FRAMES;
+
+namespace
+{
+constexpr size_t DBUS_FRAME_SIZE = 18;
+constexpr size_t DBUS_NUM_AXES = 8;
+constexpr size_t DBUS_NUM_BUTTONS = 24;
+constexpr int DBUS_CHANNEL_MIN = 364;
+constexpr int DBUS_CHANNEL_CENTER = 1024;
+constexpr int DBUS_CHANNEL_MAX = 1684;
+
+constexpr size_t SBUS_FRAME_SIZE = 25;
+constexpr size_t SBUS_NUM_CHANNELS = 16;
+constexpr size_t SBUS_FIRST_SWITCH_CHANNEL = 4;
+constexpr size_t SBUS_NUM_SWITCH_CHANNELS = 10;
+constexpr uint8_t SBUS_HEADER = 0x0F;
+constexpr uint8_t SBUS_FRAME_LOST = 0x04;
+constexpr uint8_t SBUS_FAILSAFE = 0x08;
+constexpr int SBUS_CHANNEL_CENTER = 992;
+constexpr double SBUS_CHANNEL_HALF_RANGE = 820.0;
+
+uint16_t littleEndian16(const uint8_t * bytes)
+{
+  return static_cast<uint16_t>(bytes[0] | (bytes[1] << 8));
+}
+
+void release(size_t num_axes, size_t num_buttons, JoySnapshot * joy)
+{
+  joy->num_axes = static_cast<uint32_t>(num_axes);
+  joy->num_buttons = static_cast<uint32_t>(num_buttons);
+  std::fill(joy->axes, joy->axes + JOY_MAX_AXES, 0.0f);
+  std::fill(joy->buttons, joy->buttons + JOY_MAX_BUTTONS, 0);
+}
+}  // namespace
+
+RcFrameDecoder::RcFrameDecoder(RcProtocol protocol)
+: protocol_(protocol),
+  frame_size_(protocol == RcProtocol::DBUS ? DBUS_FRAME_SIZE : SBUS_FRAME_SIZE),
+  length_(0),
+  synced_(false),
+  invalid_frames_(0),
+  lost_frames_(0)
+{
+}
+
+void RcFrameDecoder::resync()
+{
+  length_ = 0;
+  synced_ = true;
+}
+
+bool RcFrameDecoder::push(uint8_t byte, JoySnapshot * joy)
+{
+  if (protocol_ == RcProtocol::SBUS) {
+    // Self-synchronizing on the header, the gap only speeds it up.
+    if (length_ == 0 && byte != SBUS_HEADER) {
+      return false;
+    }
+  } else if (!synced_) {
+    return false;
+  }
+
+  frame_[length_++] = byte;
+  if (length_ < frame_size_) {
+    return false;
+  }
+
+  bool valid = protocol_ == RcProtocol::DBUS ? decodeDbus(joy) : decodeSbus(joy);
+  if (valid) {
+    length_ = 0;
+    return true;
+  }
+  ++invalid_frames_;
+  if (protocol_ == RcProtocol::DBUS) {
+    length_ = 0;
+    synced_ = false;
+  } else {
+    // Retry from the next header inside the rejected bytes.
+    const uint8_t * next = std::find(frame_ + 1, frame_ + length_, SBUS_HEADER);
+    length_ = static_cast<size_t>(frame_ + length_ - next);
+    std::memmove(frame_, next, length_);
+  }
+  return false;
+}
+
+bool RcFrameDecoder::decodeDbus(JoySnapshot * joy) const
+{
+  const uint8_t * b = frame_;
+  int channels[5] = {
+    (b[0] | (b[1] << 8)) & 0x07FF,
+    ((b[1] >> 3) | (b[2] << 5)) & 0x07FF,
+    ((b[2] >> 6) | (b[3] << 2) | (b[4] << 10)) & 0x07FF,
+    ((b[4] >> 1) | (b[5] << 7)) & 0x07FF,
+    // Wheel, zero on receivers without one.
+    littleEndian16(b + 16) & 0x07FF,
+  };
+  int right_switch = (b[5] >> 4) & 0x03;
+  int left_switch = (b[5] >> 6) & 0x03;
+  for (size_t i = 0; i < 4; ++i) {
+    if (channels[i] < DBUS_CHANNEL_MIN || channels[i] > DBUS_CHANNEL_MAX) {
+      return false;
+    }
+  }
+  if (left_switch == 0 || right_switch == 0) {
+    return false;
+  }
+
+  release(DBUS_NUM_AXES, DBUS_NUM_BUTTONS, joy);
+  const double half_range = DBUS_CHANNEL_MAX - DBUS_CHANNEL_CENTER;
+  for (size_t i = 0; i < 5; ++i) {
+    if (i < 4 || channels[i] != 0) {
+      joy->axes[i] = static_cast<float>((channels[i] - DBUS_CHANNEL_CENTER) / half_range);
+    }
+  }
+  for (size_t i = 0; i < 3; ++i) {
+    joy->axes[5 + i] = static_cast<float>(static_cast<int16_t>(littleEndian16(b + 6 + 2 * i)));
+  }
+  // Switch values are 1 up, 3 middle, 2 down.
+  const int position[4] = {0, 0, 2, 1};
+  joy->buttons[position[left_switch]] = 1;
+  joy->buttons[3 + position[right_switch]] = 1;
+  joy->buttons[6] = b[12] != 0;
+  joy->buttons[7] = b[13] != 0;
+  uint16_t keys = littleEndian16(b + 14);
+  for (size_t i = 0; i < 16; ++i) {
+    joy->buttons[8 + i] = (keys >> i) & 1;
+  }
+  return true;
+}
+
+bool RcFrameDecoder::decodeSbus(JoySnapshot * joy)
+{
+  const uint8_t * b = frame_;
+  // SBUS2 receivers put a telemetry slot number into the upper footer bits.
+  if (b[0] != SBUS_HEADER || (b[24] != 0x00 && (b[24] & 0x0F) != 0x04)) {
+    return false;
+  }
+
+  release(SBUS_NUM_CHANNELS, 2 + 3 * SBUS_NUM_SWITCH_CHANNELS, joy);
+  // A single lost frame repeats the last channels, a run of them is a link the
+  // receiver has not declared failsafe yet.
+  lost_frames_ = (b[23] & SBUS_FRAME_LOST) ? std::min(lost_frames_ + 1, MAX_LOST_FRAMES) : 0;
+  if ((b[23] & SBUS_FAILSAFE) || lost_frames_ == MAX_LOST_FRAMES) {
+    // Released input stops the robot until the link is back.
+    return true;
+  }
+  // 16 channels of 11 bits, packed LSB first.
+  uint32_t bits = 0;
+  int num_bits = 0;
+  size_t byte = 1;
+  for (size_t i = 0; i < SBUS_NUM_CHANNELS; ++i) {
+    while (num_bits < 11) {
+      bits |= static_cast<uint32_t>(b[byte++]) << num_bits;
+      num_bits += 8;
+    }
+    int channel = static_cast<int>(bits & 0x07FF);
+    bits >>= 11;
+    num_bits -= 11;
+    float value =
+      static_cast<float>((channel - SBUS_CHANNEL_CENTER) / SBUS_CHANNEL_HALF_RANGE);
+    joy->axes[i] = std::min(std::max(value, -1.0f), 1.0f);
+  }
+  joy->buttons[0] = b[23] & 0x01;
+  joy->buttons[1] = (b[23] >> 1) & 0x01;
+  for (size_t i = 0; i < SBUS_NUM_SWITCH_CHANNELS; ++i) {
+    float value = joy->axes[SBUS_FIRST_SWITCH_CHANNEL + i];
+    joy->buttons[2 + 3 * i + (value < -0.5f ? 0 : value > 0.5f ? 2 : 1)] = 1;
+  }
+  return true;
+}
+
+}  // namespace pb_teleop_twist_joy
@@ -0,0 +1,95 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pb_teleop_twist_joy/rc_serial_port.hpp"
+
+// termios2 for the non-standard 100000 baud, it cannot be mixed with <termios.h>.
+#include <asm/termbits.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+constexpr speed_t RC_BAUD_RATE = 100000;
+}  // namespace
+
+RcSerialPort::~RcSerialPort() { close(); }
+
+bool RcSerialPort::open(const std::string & device, RcProtocol protocol, std::string * error)
+{
+  close();
+  fd_ = ::open(device.c_str(), O_RDONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (fd_ < 0) {
+    *error = "open " + device + ": " + std::strerror(errno);
+    return false;
+  }
+
+  struct termios2 tio;
+  std::memset(&tio, 0, sizeof(tio));
+  tio.c_cflag = BOTHER | CS8 | CLOCAL | CREAD | PARENB;
+  if (protocol == RcProtocol::SBUS) {
+    tio.c_cflag |= CSTOPB;
+  }
+  tio.c_iflag = INPCK | IGNPAR;
+  tio.c_ispeed = RC_BAUD_RATE;
+  tio.c_ospeed = RC_BAUD_RATE;
+  tio.c_cc[VMIN] = 0;
+  tio.c_cc[VTIME] = 0;
+  if (ioctl(fd_, TCSETS2, &tio) != 0) {
+    *error = "configure " + device + ": " + std::strerror(errno);
+    close();
+    return false;
+  }
+  ioctl(fd_, TCFLSH, TCIFLUSH);
+  return true;
+}
+
+void RcSerialPort::close()
+{
+  if (fd_ >= 0) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+ssize_t RcSerialPort::read(uint8_t * buffer, size_t size, int timeout_ms)
+{
+  pollfd poll_fd;
+  poll_fd.fd = fd_;
+  poll_fd.events = POLLIN;
+  poll_fd.revents = 0;
+  int ready = poll(&poll_fd, 1, timeout_ms);
+  if (ready <= 0) {
+    return ready < 0 && errno != EINTR ? -1 : 0;
+  }
+  if (poll_fd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+    errno = EIO;
+    return -1;
+  }
+  ssize_t count = ::read(fd_, buffer, size);
+  if (count < 0 && (errno == EAGAIN || errno == EINTR)) {
+    return 0;
+  }
+  return count;
+}
+
+}  // namespace pb_teleop_twist_joy
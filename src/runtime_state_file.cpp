@@ -0,0 +1,156 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pb_teleop_twist_joy/runtime_state_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+
+namespace pb_teleop_twist_joy
+{
+
+constexpr size_t RuntimeStateFile::MAX_JOINTS;
+
+namespace
+{
+constexpr uint32_t STATE_FILE_MAGIC = 0x53544250;  // "PBTS"
+constexpr uint32_t STATE_FILE_VERSION = 1;
+
+uint64_t fnv1a(const void * data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL)
+{
+  const unsigned char * bytes = static_cast<const unsigned char *>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+int64_t bootTimeNs()
+{
+  timespec now;
+  clock_gettime(CLOCK_BOOTTIME, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+}  // namespace
+
+RuntimeStateFile::~RuntimeStateFile()
+{
+  if (file_ != nullptr) {
+    munmap(file_, sizeof(File));
+  }
+}
+
+bool RuntimeStateFile::open(
+  const std::string & path, const std::vector<std::string> & joint_names, std::string * error)
+{
+  if (joint_names.size() > MAX_JOINTS) {
+    *error = "more than " + std::to_string(MAX_JOINTS) + " joints";
+    return false;
+  }
+  joints_hash_ = fnv1a(nullptr, 0);
+  for (const auto & name : joint_names) {
+    // Include the terminator so {"ab", "c"} and {"a", "bc"} differ.
+    joints_hash_ = fnv1a(name.c_str(), name.size() + 1, joints_hash_);
+  }
+  if (FILE * boot_id = std::fopen("/proc/sys/kernel/random/boot_id", "r")) {
+    if (std::fgets(boot_id_, sizeof(boot_id_), boot_id) == nullptr) {
+      boot_id_[0] = '\0';
+    }
+    std::fclose(boot_id);
+  }
+
+  int fd = ::open(path.c_str(), O_CREAT | O_RDWR, 0644);
+  if (fd < 0) {
+    *error = "open " + path + ": " + std::strerror(errno);
+    return false;
+  }
+  if (ftruncate(fd, sizeof(File)) != 0) {
+    *error = "ftruncate " + path + ": " + std::strerror(errno);
+    ::close(fd);
+    return false;
+  }
+  void * address = mmap(nullptr, sizeof(File), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (address == MAP_FAILED) {
+    *error = "mmap " + path + ": " + std::strerror(errno);
+    return false;
+  }
+  file_ = static_cast<File *>(address);
+  sequence_ = std::max(file_->slots[0].sequence, file_->slots[1].sequence);
+  return true;
+}
+
+bool RuntimeStateFile::restore(
+  int64_t max_age_ns, std::vector<double> * joints, SpeedProfile * profile) const
+{
+  if (
+    file_->magic != STATE_FILE_MAGIC || file_->version != STATE_FILE_VERSION ||
+    file_->joints_hash != joints_hash_ || std::strncmp(file_->boot_id, boot_id_, 40) != 0) {
+    return false;
+  }
+  const Slot * newest = nullptr;
+  for (const Slot & slot : file_->slots) {
+    if (
+      slot.checksum == fnv1a(&slot, offsetof(Slot, checksum)) &&
+      (newest == nullptr || slot.sequence > newest->sequence)) {
+      newest = &slot;
+    }
+  }
+  int64_t age_ns = newest != nullptr ? bootTimeNs() - newest->saved_ns : max_age_ns + 1;
+  if (age_ns < 0 || age_ns > max_age_ns) {
+    return false;
+  }
+  joints->assign(newest->joints, newest->joints + newest->num_joints);
+  *profile = static_cast<SpeedProfile>(newest->profile);
+  return true;
+}
+
+void RuntimeStateFile::save(const std::vector<double> & joints, SpeedProfile profile)
+{
+  if (
+    file_->magic != STATE_FILE_MAGIC || file_->version != STATE_FILE_VERSION ||
+    file_->joints_hash != joints_hash_ || std::strncmp(file_->boot_id, boot_id_, 40) != 0) {
+    // First save with this configuration or in this boot. Invalidate both slots
+    // before the header changes, so no old state is ever taken for a new one.
+    file_->slots[0].checksum = ~fnv1a(&file_->slots[0], offsetof(Slot, checksum));
+    file_->slots[1].checksum = ~fnv1a(&file_->slots[1], offsetof(Slot, checksum));
+    file_->magic = STATE_FILE_MAGIC;
+    file_->version = STATE_FILE_VERSION;
+    file_->joints_hash = joints_hash_;
+    std::memcpy(file_->boot_id, boot_id_, sizeof(boot_id_));
+  }
+
+  // Overwrite the older slot, the newer one stays valid until this one is.
+  Slot & slot = file_->slots[++sequence_ % 2];
+  slot.sequence = sequence_;
+  slot.saved_ns = bootTimeNs();
+  slot.profile = static_cast<int32_t>(profile);
+  slot.num_joints = static_cast<uint32_t>(std::min(joints.size(), MAX_JOINTS));
+  std::copy_n(joints.begin(), slot.num_joints, slot.joints);
+  const uint64_t checksum = fnv1a(&slot, offsetof(Slot, checksum));
+  // Keep the compiler from sinking stores of the payload below the checksum,
+  // a crash in between must never leave a valid checksum over a partial slot.
+  std::atomic_signal_fence(std::memory_order_release);
+  slot.checksum = checksum;
+}
+
+}  // namespace pb_teleop_twist_joy
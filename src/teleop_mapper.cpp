@@ -0,0 +1,138 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pb_teleop_twist_joy/teleop_mapper.hpp"
+
+#include <algorithm>
+#include <string>
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+const char * const CHASSIS_FIELDS[NUM_CHASSIS_AXES] = {"x", "y", "z", "roll", "pitch", "yaw"};
+
+template <typename T>
+T lookup(const std::map<std::string, T> & map, const std::string & key, const T & fallback)
+{
+  auto it = map.find(key);
+  return it == map.end() ? fallback : it->second;
+}
+}  // namespace
+
+bool TeleopMapper::configure(const MappingConfig & config)
+{
+  require_enable_button_ = config.require_enable_button;
+  enable_button_ = config.enable_button;
+  enable_turbo_button_ = config.enable_turbo_button;
+  inverted_reverse_ = config.inverted_reverse;
+  max_integration_dt_ = config.max_integration_dt;
+  has_batch_stamp_ = false;
+
+  const auto no_scales = std::map<std::string, double>();
+  const auto & normal = lookup(config.scale_chassis, "normal", no_scales);
+  const auto & turbo = lookup(config.scale_chassis, "turbo", no_scales);
+  for (size_t i = 0; i < NUM_CHASSIS_AXES; ++i) {
+    chassis_axis_[i] = lookup(config.axis_chassis, CHASSIS_FIELDS[i], int64_t{-1});
+    chassis_scale_[0][i] = lookup(normal, CHASSIS_FIELDS[i], 0.0);
+    chassis_scale_[1][i] = lookup(turbo, CHASSIS_FIELDS[i], 0.0);
+  }
+
+  // Shooting always uses the regular scale.
+  shoot_axis_ = lookup(config.axis_gimbal, "shoot", int64_t{-1});
+  shoot_scale_ = lookup(lookup(config.scale_gimbal, "normal", no_scales), "shoot", 0.0);
+
+  return joints_.configure(config.joints);
+}
+
+void TeleopMapper::map(const JoySnapshot & joy, double dt, TeleopCommand * command)
+{
+  command->profile = selectSpeedProfile(
+    joy.button(enable_turbo_button_), joy.button(enable_button_), require_enable_button_);
+
+  if (command->profile == SpeedProfile::DISABLED) {
+    std::fill(command->chassis, command->chassis + NUM_CHASSIS_AXES, 0.0);
+  } else {
+    const bool turbo = command->profile == SpeedProfile::TURBO;
+    const double * scale = chassis_scale_[turbo ? 1 : 0];
+    for (size_t i = 0; i < NUM_CHASSIS_AXES; ++i) {
+      command->chassis[i] = joy.axis(chassis_axis_[i]) * scale[i];
+    }
+    command->chassis[ANGULAR_Z] =
+      reverseYaw(command->chassis[LINEAR_X], command->chassis[ANGULAR_Z], inverted_reverse_);
+    joints_.update(joy, turbo, dt);
+  }
+  command->shoot = joy.axis(shoot_axis_) * shoot_scale_;
+}
+
+void TeleopMapper::predictJoints(
+  const std::vector<double> & start, const JoySnapshot & joy, SpeedProfile profile, double step,
+  size_t num_steps, double * positions, double * velocities) const
+{
+  if (profile != SpeedProfile::DISABLED) {
+    joints_.predict(
+      start, joy, profile == SpeedProfile::TURBO, step, num_steps, positions, velocities);
+    return;
+  }
+  const size_t n = joints_.size();
+  for (size_t k = 0; k < num_steps; ++k) {
+    std::copy(start.begin(), start.end(), positions + k * n);
+    std::fill(velocities + k * n, velocities + (k + 1) * n, 0.0);
+  }
+}
+
+void TeleopMapper::mapBatch(const BatchInput & input, const BatchOutput & output)
+{
+  const size_t num_joints = joints_.size();
+  JoySnapshot joy;
+  joy.num_axes = static_cast<uint32_t>(std::min(input.num_axes, JOY_MAX_AXES));
+  joy.num_buttons = static_cast<uint32_t>(std::min(input.num_buttons, JOY_MAX_BUTTONS));
+  TeleopCommand command;
+
+  for (size_t row = 0; row < input.rows; ++row) {
+    const float * axes = input.axes + row * input.axes_stride;
+    std::copy(axes, axes + joy.num_axes, joy.axes);
+    const int32_t * buttons = input.buttons + row * input.buttons_stride;
+    std::copy(buttons, buttons + joy.num_buttons, joy.buttons);
+
+    double dt = 0.0;
+    if (input.stamps != nullptr) {
+      if (has_batch_stamp_) {
+        dt = std::min(std::max(input.stamps[row] - last_batch_stamp_, 0.0), max_integration_dt_);
+      }
+      has_batch_stamp_ = true;
+      last_batch_stamp_ = input.stamps[row];
+    }
+    map(joy, dt, &command);
+
+    if (output.profile != nullptr) {
+      output.profile[row] = static_cast<int8_t>(command.profile);
+    }
+    if (output.chassis != nullptr) {
+      std::copy(
+        command.chassis, command.chassis + NUM_CHASSIS_AXES,
+        output.chassis + row * NUM_CHASSIS_AXES);
+    }
+    if (output.joints != nullptr) {
+      std::copy(
+        joints_.positions().begin(), joints_.positions().end(), output.joints + row * num_joints);
+    }
+    if (output.shoot != nullptr) {
+      output.shoot[row] = command.shoot;
+    }
+  }
+}
+
+}  // namespace pb_teleop_twist_joy
@@ -0,0 +1,185 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pb_teleop_twist_joy/throttled_logger.hpp"
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+
+namespace pb_teleop_twist_joy
+{
+
+constexpr size_t ThrottledLogger::MAX_SITES;
+constexpr size_t ThrottledLogger::RING_SIZE;
+constexpr size_t ThrottledLogger::MAX_ARG_LENGTH;
+constexpr size_t ThrottledLogger::MAX_MESSAGE_LENGTH;
+
+namespace
+{
+// Rate limits are about console and rosout load, so they run on the steady
+// clock rather than on the (possibly simulated) node clock.
+int64_t steadyNowNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+void copyArg(char * destination, const char * source)
+{
+  std::strncpy(destination, source, ThrottledLogger::MAX_ARG_LENGTH - 1);
+  destination[ThrottledLogger::MAX_ARG_LENGTH - 1] = '\0';
+}
+}  // namespace
+
+ThrottledLogger::ThrottledLogger(const rclcpp::Logger & logger)
+: logger_(logger), num_sites_(0), head_(0), tail_(0), stop_(false)
+{
+  for (auto & last_message : last_messages_) {
+    last_message[0] = '\0';
+  }
+  thread_ = std::thread(&ThrottledLogger::run, this);
+}
+
+ThrottledLogger::~ThrottledLogger()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_one();
+  thread_.join();
+}
+
+size_t ThrottledLogger::registerSite(
+  RCUTILS_LOG_SEVERITY severity, const char * format, double period)
+{
+  size_t index = num_sites_.load();
+  if (index == MAX_SITES) {
+    // Out of sites, share the last one rather than failing on the hot path.
+    return MAX_SITES - 1;
+  }
+  Site & site = sites_[index];
+  site.severity = severity;
+  site.format = format;
+  site.period_ns = static_cast<int64_t>(period * 1e9);
+  site.next_allowed_ns = 0;
+  site.suppressed = 0;
+  std::snprintf(last_messages_[index], MAX_MESSAGE_LENGTH, "%s", format);
+  num_sites_ = index + 1;
+  return index;
+}
+
+void ThrottledLogger::log(size_t site_index, const char * arg0, const char * arg1)
+{
+  Site & site = sites_[site_index];
+  int64_t now_ns = steadyNowNs();
+  int64_t next_allowed_ns = site.next_allowed_ns.load(std::memory_order_relaxed);
+  if (
+    now_ns < next_allowed_ns || !site.next_allowed_ns.compare_exchange_strong(
+                                  next_allowed_ns, now_ns + site.period_ns,
+                                  std::memory_order_relaxed)) {
+    site.suppressed.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  // Never wait for the writer thread, count the message as suppressed instead.
+  std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+  if (!lock.owns_lock() || head_ - tail_ == RING_SIZE) {
+    site.suppressed.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  Record & record = ring_[head_ % RING_SIZE];
+  record.site = site_index;
+  record.suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+  copyArg(record.args[0], arg0);
+  copyArg(record.args[1], arg1);
+  ++head_;
+  lock.unlock();
+  cv_.notify_one();
+}
+
+void ThrottledLogger::write(const Site & site, const char * message)
+{
+  switch (site.severity) {
+    case RCUTILS_LOG_SEVERITY_DEBUG:
+      RCLCPP_DEBUG(logger_, "%s", message);
+      break;
+    case RCUTILS_LOG_SEVERITY_INFO:
+      RCLCPP_INFO(logger_, "%s", message);
+      break;
+    case RCUTILS_LOG_SEVERITY_ERROR:
+      RCLCPP_ERROR(logger_, "%s", message);
+      break;
+    case RCUTILS_LOG_SEVERITY_FATAL:
+      RCLCPP_FATAL(logger_, "%s", message);
+      break;
+    default:
+      RCLCPP_WARN(logger_, "%s", message);
+      break;
+  }
+}
+
+void ThrottledLogger::run()
+{
+  char message[MAX_MESSAGE_LENGTH + 64];
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait_for(lock, std::chrono::seconds(1), [this] { return stop_ || head_ != tail_; });
+
+    while (head_ != tail_) {
+      Record record = ring_[tail_ % RING_SIZE];
+      ++tail_;
+      lock.unlock();
+      const Site & site = sites_[record.site];
+      char * formatted = last_messages_[record.site];
+      std::snprintf(formatted, MAX_MESSAGE_LENGTH, site.format, record.args[0], record.args[1]);
+      if (record.suppressed > 0) {
+        std::snprintf(
+          message, sizeof(message), "%s (%" PRIu64 " similar message(s) suppressed)", formatted,
+          record.suppressed);
+        write(site, message);
+      } else {
+        write(site, formatted);
+      }
+      lock.lock();
+    }
+    if (stop_) {
+      break;
+    }
+
+    // Summarize sites that went quiet with messages still suppressed.
+    lock.unlock();
+    int64_t now_ns = steadyNowNs();
+    size_t num_sites = num_sites_.load();
+    for (size_t i = 0; i < num_sites; ++i) {
+      Site & site = sites_[i];
+      if (now_ns < site.next_allowed_ns.load(std::memory_order_relaxed)) {
+        continue;
+      }
+      uint64_t suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+      if (suppressed > 0) {
+        std::snprintf(
+          message, sizeof(message), "%" PRIu64 " more message(s) suppressed like: %s", suppressed,
+          last_messages_[i]);
+        write(site, message);
+      }
+    }
+    lock.lock();
+  }
+}
+
+}  // namespace pb_teleop_twist_joy
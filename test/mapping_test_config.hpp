@@ -0,0 +1,90 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MAPPING_TEST_CONFIG_HPP_
+#define MAPPING_TEST_CONFIG_HPP_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "pb_teleop_twist_joy/mapping_config.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+// Parameters from plain maps, for tests that do not start ROS.
+class MapParameterSource : public ParameterSource
+{
+public:
+  bool getBool(const std::string & name, bool default_value) override
+  {
+    auto it = bools.find(name);
+    return it != bools.end() ? it->second : default_value;
+  }
+  int64_t getInt(const std::string & name, int64_t default_value) override
+  {
+    auto it = ints.find(name);
+    return it != ints.end() ? it->second : default_value;
+  }
+  double getDouble(const std::string & name, double default_value) override
+  {
+    auto it = doubles.find(name);
+    return it != doubles.end() ? it->second : default_value;
+  }
+  std::string getString(const std::string & name, const std::string & default_value) override
+  {
+    auto it = strings.find(name);
+    return it != strings.end() ? it->second : default_value;
+  }
+  std::vector<std::string> getStringArray(
+    const std::string & name, const std::vector<std::string> & default_value) override
+  {
+    auto it = string_arrays.find(name);
+    return it != string_arrays.end() ? it->second : default_value;
+  }
+
+  std::map<std::string, bool> bools;
+  std::map<std::string, int64_t> ints;
+  std::map<std::string, double> doubles;
+  std::map<std::string, std::string> strings;
+  std::map<std::string, std::vector<std::string>> string_arrays;
+};
+
+// The mapping of config/xbox.config.yaml.
+inline MapParameterSource xboxParameters()
+{
+  MapParameterSource parameters;
+  parameters.bools = {{"require_enable_button", true}};
+  parameters.ints = {
+    {"enable_button", 4},      {"enable_turbo_button", 5}, {"axis_chassis.x", 1},
+    {"axis_chassis.y", 0},     {"axis_chassis.yaw", 6},    {"axis_gimbal.roll", -1},
+    {"axis_gimbal.pitch", 4},  {"axis_gimbal.yaw", 3},     {"axis_gimbal.shoot", 7},
+  };
+  parameters.doubles = {
+    {"scale_chassis.x", 2.5},        {"scale_chassis.y", 2.5},
+    {"scale_chassis.yaw", 3.0},      {"scale_chassis_turbo.x", 4.0},
+    {"scale_chassis_turbo.y", 4.0},  {"scale_chassis_turbo.yaw", 6.0},
+    {"scale_gimbal.roll", 0.0},      {"scale_gimbal.pitch", -1.0},
+    {"scale_gimbal.yaw", 2.5},       {"scale_gimbal.shoot", 1.0},
+    {"scale_gimbal_turbo.roll", 0.0}, {"scale_gimbal_turbo.pitch", -1.5},
+    {"scale_gimbal_turbo.yaw", 3.5}, {"scale_gimbal_turbo.shoot", 1.0},
+  };
+  return parameters;
+}
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // MAPPING_TEST_CONFIG_HPP_
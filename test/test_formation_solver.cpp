@@ -0,0 +1,143 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// FormationSolver on hand-computed rigid-body cases: slot velocities, the
+// rotation into each robot's base frame, stale robots and the anchoring.
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "pb_teleop_twist_joy/formation_solver.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+constexpr int64_t NOW_NS = 10000000000;
+constexpr int64_t TIMEOUT_NS = 200000000;
+constexpr double EPS = 1e-12;
+
+// One robot ahead of the center, one to its left and turned by 90 degrees.
+const std::vector<FormationSlot> SLOTS = {{1.0, 0.0, 0.0}, {0.0, 1.0, M_PI / 2}};
+
+FormationSolver makeSolver()
+{
+  FormationSolver solver;
+  solver.configure(SLOTS, 1.0, 1.0, 10.0, 10.0);
+  return solver;
+}
+
+// Puts every robot exactly on its slot of a formation centered at (x, y, yaw).
+void placeOnSlots(FormationSolver * solver, double x, double y, double yaw, int64_t stamp_ns)
+{
+  const double c = std::cos(yaw);
+  const double s = std::sin(yaw);
+  for (size_t i = 0; i < SLOTS.size(); ++i) {
+    solver->setPose(
+      i, x + c * SLOTS[i].x - s * SLOTS[i].y, y + s * SLOTS[i].x + c * SLOTS[i].y,
+      yaw + SLOTS[i].yaw, stamp_ns);
+  }
+}
+
+void expectTwist(const FormationSolver & solver, size_t robot, double x, double y, double yaw)
+{
+  SCOPED_TRACE("robot " + std::to_string(robot));
+  EXPECT_NEAR(solver.linearX()[robot], x, EPS);
+  EXPECT_NEAR(solver.linearY()[robot], y, EPS);
+  EXPECT_NEAR(solver.angularZ()[robot], yaw, EPS);
+}
+}  // namespace
+
+TEST(FormationSolverTest, RigidBodySlotVelocity)
+{
+  FormationSolver solver = makeSolver();
+  placeOnSlots(&solver, 0.0, 0.0, 0.0, NOW_NS);
+  solver.solve(0.5, 0.0, 1.0, 0.0, NOW_NS, TIMEOUT_NS);
+
+  // Slot (1, 0): 0.5 forward plus 1 rad/s times 1 m sideways.
+  expectTwist(solver, 0, 0.5, 1.0, 1.0);
+  // Slot (0, 1) moves at (0.5 - 1, 0) in the fixed frame, the robot faces +y,
+  // so that is to its left in its base frame.
+  expectTwist(solver, 1, 0.0, 0.5, 1.0);
+}
+
+TEST(FormationSolverTest, BodyFrameTwistIsIndependentOfTheFormationPose)
+{
+  // The same formation moved and turned as a whole commands the same twists.
+  FormationSolver solver = makeSolver();
+  placeOnSlots(&solver, 3.0, -2.0, 2.3, NOW_NS);
+  solver.solve(0.5, -0.25, 1.0, 0.0, NOW_NS, TIMEOUT_NS);
+  FormationSolver reference = makeSolver();
+  placeOnSlots(&reference, 0.0, 0.0, 0.0, NOW_NS);
+  reference.solve(0.5, -0.25, 1.0, 0.0, NOW_NS, TIMEOUT_NS);
+
+  for (size_t i = 0; i < SLOTS.size(); ++i) {
+    expectTwist(
+      solver, i, reference.linearX()[i], reference.linearY()[i], reference.angularZ()[i]);
+  }
+}
+
+TEST(FormationSolverTest, StaleRobotGetsZeroTwist)
+{
+  FormationSolver solver = makeSolver();
+  placeOnSlots(&solver, 0.0, 0.0, 0.0, NOW_NS);
+  solver.setPose(1, 0.0, 1.0, M_PI / 2, NOW_NS - 2 * TIMEOUT_NS);
+  solver.solve(0.5, 0.0, 1.0, 0.0, NOW_NS, TIMEOUT_NS);
+
+  expectTwist(solver, 0, 0.5, 1.0, 1.0);
+  expectTwist(solver, 1, 0.0, 0.0, 0.0);
+}
+
+TEST(FormationSolverTest, NoFreshPoseGivesZeroTwists)
+{
+  FormationSolver solver = makeSolver();
+  solver.solve(0.5, 0.0, 1.0, 0.1, NOW_NS, TIMEOUT_NS);
+  expectTwist(solver, 0, 0.0, 0.0, 0.0);
+  expectTwist(solver, 1, 0.0, 0.0, 0.0);
+
+  // Anchors once poses arrive.
+  placeOnSlots(&solver, 0.0, 0.0, 0.0, NOW_NS);
+  solver.solve(0.5, 0.0, 1.0, 0.0, NOW_NS, TIMEOUT_NS);
+  expectTwist(solver, 0, 0.5, 1.0, 1.0);
+}
+
+TEST(FormationSolverTest, AnchoringIgnoresStalePoses)
+{
+  FormationSolver solver = makeSolver();
+  solver.setPose(0, 1.0, 0.0, 0.0, NOW_NS);
+  // Far off its slot, it would drag the center away if it counted.
+  solver.setPose(1, 10.0, 10.0, 2.0, NOW_NS - 2 * TIMEOUT_NS);
+  solver.solve(0.0, 0.0, 0.0, 0.0, NOW_NS, TIMEOUT_NS);
+
+  // The center sits where robot 0 puts it, so robot 0 needs no correction.
+  expectTwist(solver, 0, 0.0, 0.0, 0.0);
+  expectTwist(solver, 1, 0.0, 0.0, 0.0);
+
+  // Once fresh, robot 1 is corrected towards its slot at (0, 1) facing +y: by
+  // (-10, -9) in the fixed frame, rotated into its base frame, and turning by
+  // its heading error.
+  solver.setPose(1, 10.0, 10.0, 2.0, NOW_NS);
+  solver.solve(0.0, 0.0, 0.0, 0.0, NOW_NS, TIMEOUT_NS);
+  expectTwist(solver, 0, 0.0, 0.0, 0.0);
+  const double c = std::cos(2.0);
+  const double s = std::sin(2.0);
+  expectTwist(solver, 1, -10.0 * c - 9.0 * s, -9.0 * c + 10.0 * s, M_PI / 2 - 2.0);
+}
+
+}  // namespace pb_teleop_twist_joy
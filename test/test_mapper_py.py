@@ -0,0 +1,84 @@
+# Copyright 2025 Lihan Chen
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Sessions through the Python module, mapped at once and in chunks."""
+
+import numpy as np
+import pytest
+
+pb_teleop_twist_joy_py = pytest.importorskip("pb_teleop_twist_joy_py")
+
+# The mapping of config/xbox.config.yaml.
+XBOX = {
+    "pb_teleop_twist_joy": {
+        "ros__parameters": {
+            "require_enable_button": True,
+            "enable_button": 4,
+            "enable_turbo_button": 5,
+            "axis_chassis": {"x": 1, "y": 0, "yaw": 6},
+            "scale_chassis": {"x": 2.5, "y": 2.5, "yaw": 3.0},
+            "scale_chassis_turbo": {"x": 4.0, "y": 4.0, "yaw": 6.0},
+            "axis_gimbal": {"roll": -1, "pitch": 4, "yaw": 3, "shoot": 7},
+            "scale_gimbal": {"roll": 0.0, "pitch": -1.0, "yaw": 2.5, "shoot": 1.0},
+            "scale_gimbal_turbo": {
+                "roll": 0.0,
+                "pitch": -1.5,
+                "yaw": 3.5,
+                "shoot": 1.0,
+            },
+        }
+    }
+}
+ROWS = 2000
+
+
+def session(seed):
+    """Random sticks, enable held most of the time, stamps about 100 Hz."""
+    rng = np.random.default_rng(seed)
+    axes = rng.uniform(-1.0, 1.0, (ROWS, 8)).astype(np.float32)
+    buttons = np.zeros((ROWS, 11), dtype=np.int32)
+    buttons[:, 4] = rng.random(ROWS) < 0.9
+    buttons[:, 5] = rng.random(ROWS) < 0.3
+    # Jitter and the odd gap above max_integration_dt.
+    stamps = 100.0 + np.cumsum(rng.uniform(0.005, 0.015, ROWS))
+    stamps[ROWS // 2 :] += 0.5
+    return axes, buttons, stamps
+
+
+@pytest.mark.parametrize("chunks", [[1, ROWS - 1], [37, 500, 1], [ROWS // 2]])
+def test_chunked_matches_single_call(chunks):
+    axes, buttons, stamps = session(7)
+    whole = pb_teleop_twist_joy_py.Mapper(XBOX).map_batch(axes, buttons, stamps)
+
+    mapper = pb_teleop_twist_joy_py.Mapper(XBOX)
+    bounds = [0] + list(np.cumsum(chunks)) + [ROWS]
+    parts = [
+        mapper.map_batch(axes[a:b], buttons[a:b], stamps[a:b])
+        for a, b in zip(bounds[:-1], bounds[1:])
+    ]
+    for key in ("profile", "chassis", "joints", "shoot"):
+        np.testing.assert_array_equal(
+            np.concatenate([part[key] for part in parts]), whole[key], err_msg=key
+        )
+    assert np.any(whole["joints"] != 0.0)
+
+
+def test_reset_starts_a_new_session():
+    axes, buttons, stamps = session(11)
+    mapper = pb_teleop_twist_joy_py.Mapper(XBOX)
+    first = mapper.map_batch(axes, buttons, stamps)
+    mapper.reset()
+    # Joints restart from zero and the stamps need not follow the last call.
+    again = mapper.map_batch(axes, buttons, stamps - 50.0)
+    np.testing.assert_array_equal(again["joints"], first["joints"])
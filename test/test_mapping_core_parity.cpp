@@ -0,0 +1,446 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Parity of the constexpr mapping core with TeleopMapper. The xbox mapping is
+// evaluated at compile time and checked with static_assert, then TeleopMapper
+// has to reach the same values at run time. A random session then runs through
+// both with the xbox and an arm configuration, and through the Fixed<16>
+// instantiation firmware without an FPU runs, within its quantisation error.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "mapping_test_config.hpp"
+#include "pb_teleop_twist_joy/mapping_core.hpp"
+#include "pb_teleop_twist_joy/teleop_mapper.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+constexpr size_t MAX_JOINTS = 4;
+constexpr size_t NUM_AXES = 8;
+constexpr size_t NUM_BUTTONS = 11;
+
+using Config = CoreMappingConfig<double, MAX_JOINTS>;
+using Command = CoreCommand<double, MAX_JOINTS>;
+using FixedScalar = Fixed<16>;
+using FixedConfig = CoreMappingConfig<FixedScalar, MAX_JOINTS>;
+using FixedCommand = CoreCommand<FixedScalar, MAX_JOINTS>;
+
+// Quantisation tolerance of Fixed<16> against double. One rounding, of a
+// conversion or a product, is off by at most half an LSB.
+constexpr double FIXED_ROUNDING = 1.0 / (1 << 17);
+// A chassis or shoot command is a rounded axis, |axis| <= 1, times a rounded
+// scale, |scale| <= 6: |scale| + |axis| + 1 roundings.
+constexpr double FIXED_COMMAND_TOLERANCE = 8 * FIXED_ROUNDING;
+// A joint step adds command * dt with |command| <= 3.5 and dt <= 0.1: the
+// command error times dt, |command| times the rounding of dt and one rounding
+// of the product. Clamping to a rounded limit adds at most one more. Rate
+// joints accumulate this every step.
+constexpr double FIXED_JOINT_STEP_TOLERANCE = 8 * FIXED_ROUNDING;
+constexpr size_t FIXED_SESSION_STEPS = 2000;
+
+struct Sample
+{
+  double axes[NUM_AXES];
+  int32_t buttons[NUM_BUTTONS];
+  double dt;
+};
+
+// config/xbox.config.yaml as firmware would hold it.
+constexpr Config xboxCoreConfig()
+{
+  Config config;
+  config.enable_button = 4;
+  config.enable_turbo_button = 5;
+  config.chassis_axis[LINEAR_X] = 1;
+  config.chassis_axis[LINEAR_Y] = 0;
+  config.chassis_axis[ANGULAR_Z] = 6;
+  config.chassis_scale[0][LINEAR_X] = 2.5;
+  config.chassis_scale[0][LINEAR_Y] = 2.5;
+  config.chassis_scale[0][ANGULAR_Z] = 3.0;
+  config.chassis_scale[1][LINEAR_X] = 4.0;
+  config.chassis_scale[1][LINEAR_Y] = 4.0;
+  config.chassis_scale[1][ANGULAR_Z] = 6.0;
+  config.shoot_axis = 7;
+  config.shoot_scale = 1.0;
+  config.num_joints = 2;
+  config.joints[0].axis = 4;
+  config.joints[0].scale = -1.0;
+  config.joints[0].scale_turbo = -1.5;
+  config.joints[0].output_index = 0;
+  config.joints[1].axis = 3;
+  config.joints[1].scale = 2.5;
+  config.joints[1].scale_turbo = 3.5;
+  config.joints[1].output_index = 1;
+  return config;
+}
+
+// Enabled, turbo, disabled, enabled without the turbo button. Values are
+// exact in binary so the expectations below hold bit for bit.
+constexpr Sample SESSION[] = {
+  {{0.5, -1.0, 0.0, 0.5, 0.25, 0.0, 1.0, 0.75}, {0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0}, 0.25},
+  {{-0.5, 0.5, 0.0, -1.0, 0.5, 0.0, -1.0, 0.0}, {0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0}, 0.25},
+  {{1.0, 1.0, 0.0, 1.0, 1.0, 0.0, 1.0, 0.5}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}, 0.25},
+  {{0.0, 0.25, 0.0, 0.5, -0.5, 0.0, 0.5, 0.0}, {0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0}, 0.5},
+};
+constexpr size_t SESSION_SIZE = sizeof(SESSION) / sizeof(SESSION[0]);
+
+constexpr Command mapCoreSession(const Config & config, size_t steps)
+{
+  Command command;
+  resetCoreCommand(config, &command);
+  for (size_t i = 0; i < steps; ++i) {
+    mapCoreCommand(
+      config, SESSION[i].axes, NUM_AXES, SESSION[i].buttons, NUM_BUTTONS, SESSION[i].dt, &command);
+  }
+  return command;
+}
+
+constexpr Config XBOX = xboxCoreConfig();
+constexpr Command AFTER_ENABLED = mapCoreSession(XBOX, 1);
+constexpr Command AFTER_TURBO = mapCoreSession(XBOX, 2);
+constexpr Command AFTER_DISABLED = mapCoreSession(XBOX, 3);
+constexpr Command AFTER_SESSION = mapCoreSession(XBOX, SESSION_SIZE);
+
+static_assert(AFTER_ENABLED.profile == SpeedProfile::NORMAL, "enable button selects normal");
+static_assert(AFTER_ENABLED.chassis[LINEAR_X] == -2.5, "linear x is axis 1 times 2.5");
+static_assert(AFTER_ENABLED.chassis[LINEAR_Y] == 1.25, "linear y is axis 0 times 2.5");
+static_assert(AFTER_ENABLED.chassis[ANGULAR_Z] == 3.0, "angular z is axis 6 times 3");
+static_assert(AFTER_ENABLED.shoot == 0.75, "shoot is axis 7");
+static_assert(AFTER_ENABLED.joints[0] == -0.0625, "pitch integrates -0.25 for 0.25 s");
+static_assert(AFTER_ENABLED.joints[1] == 0.3125, "yaw integrates 1.25 for 0.25 s");
+
+static_assert(AFTER_TURBO.profile == SpeedProfile::TURBO, "turbo button selects turbo");
+static_assert(AFTER_TURBO.chassis[LINEAR_X] == 2.0, "turbo scales linear x by 4");
+static_assert(AFTER_TURBO.chassis[ANGULAR_Z] == -6.0, "turbo scales angular z by 6");
+static_assert(AFTER_TURBO.joints[0] == -0.25, "pitch integrates -0.75 for 0.25 s");
+static_assert(AFTER_TURBO.joints[1] == -0.5625, "yaw integrates -3.5 for 0.25 s");
+
+static_assert(AFTER_DISABLED.profile == SpeedProfile::DISABLED, "no button disables");
+static_assert(AFTER_DISABLED.chassis[LINEAR_X] == 0.0, "disabled chassis stops");
+static_assert(AFTER_DISABLED.joints[1] == AFTER_TURBO.joints[1], "disabled joints hold");
+static_assert(AFTER_DISABLED.shoot == 0.5, "shoot ignores the enable button");
+
+static_assert(AFTER_SESSION.profile == SpeedProfile::NORMAL, "enable button selects normal");
+static_assert(AFTER_SESSION.joints[0] == 0.0, "pitch integrates 0.5 for 0.5 s");
+static_assert(AFTER_SESSION.joints[1] == 0.0625, "yaw integrates 1.25 for 0.5 s");
+
+// The core configuration equivalent to what TeleopMapper::configure() reads.
+Config coreConfig(const MappingConfig & mapping)
+{
+  const char * const fields[NUM_CHASSIS_AXES] = {"x", "y", "z", "roll", "pitch", "yaw"};
+  Config config;
+  config.require_enable_button = mapping.require_enable_button;
+  config.enable_button = static_cast<int16_t>(mapping.enable_button);
+  config.enable_turbo_button = static_cast<int16_t>(mapping.enable_turbo_button);
+  config.inverted_reverse = mapping.inverted_reverse;
+  for (size_t i = 0; i < NUM_CHASSIS_AXES; ++i) {
+    auto axis = mapping.axis_chassis.find(fields[i]);
+    config.chassis_axis[i] =
+      static_cast<int16_t>(axis == mapping.axis_chassis.end() ? -1 : axis->second);
+    const auto & normal = mapping.scale_chassis.at("normal");
+    const auto & turbo = mapping.scale_chassis.at("turbo");
+    config.chassis_scale[0][i] = normal.count(fields[i]) ? normal.at(fields[i]) : 0.0;
+    config.chassis_scale[1][i] = turbo.count(fields[i]) ? turbo.at(fields[i]) : 0.0;
+  }
+  config.shoot_axis = static_cast<int16_t>(mapping.axis_gimbal.at("shoot"));
+  config.shoot_scale = mapping.scale_gimbal.at("normal").at("shoot");
+  config.num_joints = mapping.joints.size();
+  for (size_t i = 0; i < mapping.joints.size(); ++i) {
+    const JointBinding & binding = mapping.joints[i];
+    config.joints[i].axis = static_cast<int16_t>(binding.axis);
+    config.joints[i].scale = binding.scale;
+    config.joints[i].scale_turbo = binding.scale_turbo;
+    config.joints[i].integrate = binding.mode == JointMode::RATE;
+    config.joints[i].min = binding.min;
+    config.joints[i].max = binding.max;
+    config.joints[i].output_index = static_cast<uint8_t>(binding.output_index);
+  }
+  return config;
+}
+
+FixedConfig fixedConfig(const Config & config)
+{
+  FixedConfig fixed;
+  fixed.require_enable_button = config.require_enable_button;
+  fixed.enable_button = config.enable_button;
+  fixed.enable_turbo_button = config.enable_turbo_button;
+  fixed.inverted_reverse = config.inverted_reverse;
+  for (size_t i = 0; i < NUM_CHASSIS_AXES; ++i) {
+    fixed.chassis_axis[i] = config.chassis_axis[i];
+    fixed.chassis_scale[0][i] = toScalar<FixedScalar>(config.chassis_scale[0][i]);
+    fixed.chassis_scale[1][i] = toScalar<FixedScalar>(config.chassis_scale[1][i]);
+  }
+  fixed.shoot_axis = config.shoot_axis;
+  fixed.shoot_scale = toScalar<FixedScalar>(config.shoot_scale);
+  fixed.num_joints = config.num_joints;
+  for (size_t i = 0; i < config.num_joints; ++i) {
+    fixed.joints[i].axis = config.joints[i].axis;
+    fixed.joints[i].scale = toScalar<FixedScalar>(config.joints[i].scale);
+    fixed.joints[i].scale_turbo = toScalar<FixedScalar>(config.joints[i].scale_turbo);
+    fixed.joints[i].integrate = config.joints[i].integrate;
+    fixed.joints[i].min = toScalar<FixedScalar>(config.joints[i].min);
+    fixed.joints[i].max = toScalar<FixedScalar>(config.joints[i].max);
+    fixed.joints[i].output_index = config.joints[i].output_index;
+  }
+  return fixed;
+}
+
+TeleopMapper configuredMapper(MapParameterSource parameters)
+{
+  TeleopMapper mapper;
+  EXPECT_TRUE(mapper.configure(loadMappingConfig(&parameters)));
+  return mapper;
+}
+
+// The arm of the commented example in xbox.config.yaml, with the output order
+// swapped, inverted reverse and the turbo button out of reach of short inputs.
+MapParameterSource armParameters()
+{
+  MapParameterSource parameters = xboxParameters();
+  parameters.bools["inverted_reverse"] = true;
+  parameters.ints["enable_turbo_button"] = 9;
+  parameters.string_arrays["joints"] = {"shoulder_joint", "elbow_joint", "wrist_joint"};
+  parameters.ints["joint.shoulder_joint.axis"] = 4;
+  parameters.doubles["joint.shoulder_joint.scale"] = 1.0;
+  parameters.doubles["joint.shoulder_joint.scale_turbo"] = 2.0;
+  parameters.doubles["joint.shoulder_joint.min"] = -1.57;
+  parameters.doubles["joint.shoulder_joint.max"] = 1.57;
+  parameters.ints["joint.shoulder_joint.output_index"] = 2;
+  parameters.ints["joint.elbow_joint.axis"] = 3;
+  parameters.doubles["joint.elbow_joint.scale"] = 1.2;
+  parameters.strings["joint.elbow_joint.mode"] = "position";
+  parameters.ints["joint.elbow_joint.output_index"] = 0;
+  // Zero is outside the limits, the wrist starts at the nearest one.
+  parameters.ints["joint.wrist_joint.axis"] = 2;
+  parameters.doubles["joint.wrist_joint.scale"] = 0.7;
+  parameters.doubles["joint.wrist_joint.min"] = 0.2;
+  parameters.doubles["joint.wrist_joint.max"] = 0.9;
+  parameters.ints["joint.wrist_joint.output_index"] = 1;
+  return parameters;
+}
+
+// Deterministic inputs, including messages too short for some bindings.
+class Lcg
+{
+public:
+  uint32_t next()
+  {
+    state_ = state_ * 6364136223846793005ULL + 1442695040888963407ULL;
+    return static_cast<uint32_t>(state_ >> 33);
+  }
+  double uniform() { return next() / 2147483648.0; }
+
+private:
+  uint64_t state_ = 0x5eed;
+};
+
+void expectSameCommand(
+  const TeleopCommand & command, const std::vector<double> & joints, const Command & core,
+  size_t num_joints, size_t step)
+{
+  SCOPED_TRACE("step " + std::to_string(step));
+  EXPECT_EQ(command.profile, core.profile);
+  for (size_t i = 0; i < NUM_CHASSIS_AXES; ++i) {
+    EXPECT_DOUBLE_EQ(command.chassis[i], core.chassis[i]) << "chassis axis " << i;
+  }
+  EXPECT_DOUBLE_EQ(command.shoot, core.shoot);
+  ASSERT_EQ(joints.size(), num_joints);
+  for (size_t i = 0; i < num_joints; ++i) {
+    EXPECT_DOUBLE_EQ(joints[i], core.joints[i]) << "joint " << i;
+  }
+}
+
+// One random input with `axes` holding the joy axes as double.
+double randomSample(Lcg * random, JoySnapshot * joy, double (&axes)[NUM_AXES])
+{
+  joy->num_axes = 4 + random->next() % 5;
+  joy->num_buttons = 5 + random->next() % 7;
+  std::fill(axes, axes + NUM_AXES, 0.0);
+  for (size_t i = 0; i < joy->num_axes; ++i) {
+    joy->axes[i] = static_cast<float>(2.0 * random->uniform() - 1.0);
+    axes[i] = joy->axes[i];
+  }
+  for (size_t i = 0; i < joy->num_buttons; ++i) {
+    joy->buttons[i] = random->next() % 3 == 0 ? 1 : 0;
+  }
+  return 0.1 * random->uniform();
+}
+
+Config loadCoreConfig(MapParameterSource parameters)
+{
+  return coreConfig(loadMappingConfig(&parameters));
+}
+
+void runRandomSession(const MapParameterSource & parameters)
+{
+  const Config config = loadCoreConfig(parameters);
+  TeleopMapper mapper = configuredMapper(parameters);
+
+  Command core;
+  resetCoreCommand(config, &core);
+  TeleopCommand command;
+  expectSameCommand(command, mapper.joints().positions(), core, config.num_joints, 0);
+
+  Lcg random;
+  for (size_t step = 1; step <= 10000; ++step) {
+    JoySnapshot joy;
+    double axes[NUM_AXES];
+    const double dt = randomSample(&random, &joy, axes);
+
+    mapper.map(joy, dt, &command);
+    mapCoreCommand(config, axes, joy.num_axes, joy.buttons, joy.num_buttons, dt, &core);
+    expectSameCommand(command, mapper.joints().positions(), core, config.num_joints, step);
+    if (::testing::Test::HasFailure()) {
+      return;
+    }
+  }
+}
+
+// The same random inputs through the double and the Fixed<16> core.
+void runFixedSession(const MapParameterSource & parameters)
+{
+  const Config config = loadCoreConfig(parameters);
+  const FixedConfig fixed_config = fixedConfig(config);
+
+  Command core;
+  resetCoreCommand(config, &core);
+  FixedCommand fixed;
+  resetCoreCommand(fixed_config, &fixed);
+
+  Lcg random;
+  double max_joint_error = 0.0;
+  for (size_t step = 1; step <= FIXED_SESSION_STEPS; ++step) {
+    SCOPED_TRACE("step " + std::to_string(step));
+    JoySnapshot joy;
+    double axes[NUM_AXES];
+    const double dt = randomSample(&random, &joy, axes);
+    FixedScalar fixed_axes[NUM_AXES];
+    for (size_t i = 0; i < NUM_AXES; ++i) {
+      fixed_axes[i] = toScalar<FixedScalar>(axes[i]);
+    }
+
+    mapCoreCommand(config, axes, joy.num_axes, joy.buttons, joy.num_buttons, dt, &core);
+    mapCoreCommand(
+      fixed_config, fixed_axes, joy.num_axes, joy.buttons, joy.num_buttons,
+      toScalar<FixedScalar>(dt), &fixed);
+
+    ASSERT_EQ(fixed.profile, core.profile);
+    for (size_t i = 0; i < NUM_CHASSIS_AXES; ++i) {
+      double expected = core.chassis[i];
+      double actual = fixed.chassis[i].toDouble();
+      if (
+        i == ANGULAR_Z && config.inverted_reverse &&
+        std::abs(core.chassis[LINEAR_X]) <= FIXED_COMMAND_TOLERANCE) {
+        // A linear x within rounding of zero may take either sign, and with it
+        // the yaw.
+        expected = std::abs(expected);
+        actual = std::abs(actual);
+      }
+      ASSERT_NEAR(actual, expected, FIXED_COMMAND_TOLERANCE) << "chassis axis " << i;
+    }
+    ASSERT_NEAR(fixed.shoot.toDouble(), core.shoot, FIXED_COMMAND_TOLERANCE);
+    for (size_t i = 0; i < config.num_joints; ++i) {
+      const double error = std::abs(fixed.joints[i].toDouble() - core.joints[i]);
+      ASSERT_LE(error, static_cast<double>(step) * FIXED_JOINT_STEP_TOLERANCE) << "joint " << i;
+      max_joint_error = std::max(max_joint_error, error);
+    }
+  }
+  ::testing::Test::RecordProperty("max_joint_error", std::to_string(max_joint_error));
+}
+}  // namespace
+
+TEST(MappingCoreParityTest, TeleopMapperMatchesCompileTimeCore)
+{
+  TeleopMapper mapper = configuredMapper(xboxParameters());
+  const Command * expected[] = {&AFTER_ENABLED, &AFTER_TURBO, &AFTER_DISABLED, &AFTER_SESSION};
+  TeleopCommand command;
+  for (size_t i = 0; i < SESSION_SIZE; ++i) {
+    JoySnapshot joy;
+    joy.num_axes = NUM_AXES;
+    joy.num_buttons = NUM_BUTTONS;
+    for (size_t j = 0; j < NUM_AXES; ++j) {
+      joy.axes[j] = static_cast<float>(SESSION[i].axes[j]);
+    }
+    for (size_t j = 0; j < NUM_BUTTONS; ++j) {
+      joy.buttons[j] = SESSION[i].buttons[j];
+    }
+    mapper.map(joy, SESSION[i].dt, &command);
+    expectSameCommand(command, mapper.joints().positions(), *expected[i], 2, i + 1);
+  }
+}
+
+TEST(MappingCoreParityTest, XboxRandomSession) { runRandomSession(xboxParameters()); }
+
+TEST(MappingCoreParityTest, ArmRandomSession) { runRandomSession(armParameters()); }
+
+TEST(MappingCoreParityTest, FixedXboxRandomSession) { runFixedSession(xboxParameters()); }
+
+TEST(MappingCoreParityTest, FixedArmRandomSession) { runFixedSession(armParameters()); }
+
+TEST(MappingCoreParityTest, FixedSaturatesAtTheLimits)
+{
+  const int32_t raw_max = std::numeric_limits<int32_t>::max();
+  const int32_t raw_min = std::numeric_limits<int32_t>::min();
+  EXPECT_EQ(toScalar<FixedScalar>(1e9).raw(), raw_max);
+  EXPECT_EQ(toScalar<FixedScalar>(-1e9).raw(), raw_min);
+  EXPECT_EQ(toScalar<FixedScalar>(std::numeric_limits<double>::infinity()).raw(), raw_max);
+
+  FixedConfig config;
+  config.require_enable_button = false;
+  config.chassis_axis[LINEAR_X] = 0;
+  // Beyond the range of Fixed<16>, so it saturates on conversion.
+  config.chassis_scale[0][LINEAR_X] = toScalar<FixedScalar>(1e6);
+  config.num_joints = 2;
+  // Unlimited, runs into the end of the range within two steps.
+  config.joints[0].axis = 0;
+  config.joints[0].scale = toScalar<FixedScalar>(20000.0);
+  config.joints[0].output_index = 0;
+  config.joints[1].axis = 0;
+  config.joints[1].scale = toScalar<FixedScalar>(4.0);
+  config.joints[1].min = toScalar<FixedScalar>(-1.0);
+  config.joints[1].max = toScalar<FixedScalar>(1.5);
+  config.joints[1].output_index = 1;
+
+  FixedCommand command;
+  resetCoreCommand(config, &command);
+  const FixedScalar dt = toScalar<FixedScalar>(1.0);
+  const int32_t no_buttons[1] = {0};
+  for (FixedScalar axis : {toScalar<FixedScalar>(1.0), toScalar<FixedScalar>(-1.0)}) {
+    const bool forward = axis == toScalar<FixedScalar>(1.0);
+    SCOPED_TRACE(forward ? "forward" : "backward");
+    for (int step = 0; step < 4; ++step) {
+      mapCoreCommand(config, &axis, 1, no_buttons, 0, dt, &command);
+      // Saturated, never wrapped to the other sign.
+      if (forward) {
+        EXPECT_GT(command.joints[0].toDouble(), 0.0);
+      }
+    }
+    EXPECT_EQ(command.chassis[LINEAR_X].raw(), forward ? raw_max : -raw_max);
+    EXPECT_EQ(command.joints[0].raw(), forward ? raw_max : raw_min);
+    EXPECT_EQ(command.joints[1], toScalar<FixedScalar>(forward ? 1.5 : -1.0));
+  }
+}
+
+}  // namespace pb_teleop_twist_joy
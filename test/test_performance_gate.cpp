@@ -0,0 +1,399 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Performance regression gate: times TeleopMapper::map, the serialized joy
+// decode, TeleopMapper::mapBatch over a recorded session and a formation solve
+// for a large group, counts heap allocations per message, and compares against
+// the baselines of this architecture in test/perf_baselines. Every run writes a
+// JSON report, gtest writes the JUnit one.
+//
+// These are the ROS-free kernels of the joy callback only. The callback with
+// message filling and publishing is timed by the statistics diagnostics and by
+// wcet_stress on the target.
+//
+// Timings are only compared in optimized builds. PERF_GATE_UPDATE_BASELINE=1
+// writes the measured values as the baseline of this architecture.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "allocation_counter.hpp"
+#include "mapping_test_config.hpp"
+#include "pb_teleop_twist_joy/formation_solver.hpp"
+#include "pb_teleop_twist_joy/joy_cdr_decoder.hpp"
+#include "pb_teleop_twist_joy/teleop_mapper.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+constexpr size_t SESSION_SIZE = 4096;
+constexpr size_t BATCH_ROWS = 100000;
+constexpr size_t FORMATION_ROBOTS = 32;
+constexpr int BATCHES = 201;
+// Loose enough for the run to run noise of a median on a shared CI machine,
+// tight enough that a 1.5 times slower kernel fails.
+constexpr double DEFAULT_TOLERANCE = 0.3;
+
+enum class Better
+{
+  LOWER,
+  HIGHER,
+};
+
+struct Metric
+{
+  std::string name;
+  Better better;
+  double value = 0.0;
+  bool has_baseline = false;
+  double baseline = 0.0;
+  double tolerance = DEFAULT_TOLERANCE;
+
+  // Lower is better: fail above baseline * (1 + tolerance). Higher is better:
+  // fail below baseline / (1 + tolerance).
+  double limit() const
+  {
+    return better == Better::LOWER ? baseline * (1.0 + tolerance) : baseline / (1.0 + tolerance);
+  }
+  bool passed() const
+  {
+    return !has_baseline || (better == Better::LOWER ? value <= limit() : value >= limit());
+  }
+};
+
+// A driving session: sticks sweeping, enable held with short releases and
+// turbo phases, so every branch of the mapping runs.
+std::vector<JoySnapshot> makeSession()
+{
+  std::vector<JoySnapshot> session(SESSION_SIZE);
+  for (size_t i = 0; i < SESSION_SIZE; ++i) {
+    JoySnapshot & joy = session[i];
+    double k = static_cast<double>(i);
+    joy.stamp_ns = static_cast<int64_t>(i) * 10000000;
+    joy.num_axes = 8;
+    joy.num_buttons = 11;
+    joy.axes[0] = static_cast<float>(std::sin(0.05 * k));
+    joy.axes[1] = static_cast<float>(std::cos(0.03 * k));
+    joy.axes[3] = static_cast<float>(0.5 * std::sin(0.02 * k));
+    joy.axes[4] = static_cast<float>(-0.7 * std::cos(0.04 * k));
+    joy.axes[6] = (i / 64) % 3 == 0 ? 1.0f : 0.0f;
+    joy.axes[7] = (i / 32) % 2 == 0 ? 1.0f : 0.0f;
+    joy.buttons[4] = i % 500 < 480 ? 1 : 0;
+    joy.buttons[5] = (i / 256) % 2;
+  }
+  return session;
+}
+
+// sensor_msgs/msg/Joy in little endian CDR, as a gamepad joy_node sends it.
+std::vector<uint8_t> serializeJoy(const JoySnapshot & joy)
+{
+  std::vector<uint8_t> buffer = {0x00, 0x01, 0x00, 0x00};
+  auto put32 = [&buffer](uint32_t value) {
+    while ((buffer.size() - 4) % 4 != 0) {
+      buffer.push_back(0);
+    }
+    uint8_t bytes[4];
+    std::memcpy(bytes, &value, 4);
+    buffer.insert(buffer.end(), bytes, bytes + 4);
+  };
+  put32(static_cast<uint32_t>(joy.stamp_ns / 1000000000));
+  put32(static_cast<uint32_t>(joy.stamp_ns % 1000000000));
+  const char frame_id[] = "joy";
+  put32(sizeof(frame_id));
+  buffer.insert(buffer.end(), frame_id, frame_id + sizeof(frame_id));
+  put32(joy.num_axes);
+  for (uint32_t i = 0; i < joy.num_axes; ++i) {
+    uint32_t bits;
+    std::memcpy(&bits, &joy.axes[i], 4);
+    put32(bits);
+  }
+  put32(joy.num_buttons);
+  for (uint32_t i = 0; i < joy.num_buttons; ++i) {
+    put32(static_cast<uint32_t>(joy.buttons[i]));
+  }
+  return buffer;
+}
+
+// Median time per message over batches of `batch_size` messages, and heap
+// allocations per message over all of them.
+template <typename Run>
+void timeBatches(size_t batch_size, Run run, double * median_ns, double * allocations_per_message)
+{
+  std::vector<double> batch_ns(BATCHES);
+  uint64_t allocations_before = allocationCount();
+  for (int batch = 0; batch < BATCHES; ++batch) {
+    auto start = std::chrono::steady_clock::now();
+    run();
+    batch_ns[batch] =
+      std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+      static_cast<double>(batch_size);
+  }
+  uint64_t allocations_after = allocationCount();
+  std::nth_element(batch_ns.begin(), batch_ns.begin() + BATCHES / 2, batch_ns.end());
+  *median_ns = batch_ns[BATCHES / 2];
+  *allocations_per_message = static_cast<double>(allocations_after - allocations_before) /
+                             (static_cast<double>(BATCHES) * static_cast<double>(batch_size));
+}
+
+std::string baselinePath()
+{
+  return std::string(PERF_GATE_BASELINE_DIR) + "/" + PERF_GATE_ARCH + ".txt";
+}
+
+// Lines of "name baseline tolerance", '#' starts a comment.
+void loadBaselines(std::vector<Metric> * metrics)
+{
+  std::ifstream file(baselinePath());
+  std::string line;
+  while (std::getline(file, line)) {
+    std::istringstream fields(line.substr(0, line.find('#')));
+    std::string name;
+    double baseline;
+    double tolerance;
+    if (!(fields >> name >> baseline >> tolerance)) {
+      continue;
+    }
+    for (Metric & metric : *metrics) {
+      if (metric.name == name) {
+        metric.has_baseline = true;
+        metric.baseline = baseline;
+        metric.tolerance = tolerance;
+      }
+    }
+  }
+}
+
+void writeBaselines(const std::vector<Metric> & metrics)
+{
+  std::ofstream file(baselinePath());
+  file << "# Performance gate baselines for " << PERF_GATE_ARCH << ", see test_performance_gate.\n"
+       << "# name baseline tolerance\n";
+  for (const Metric & metric : metrics) {
+    file << metric.name << " " << metric.value << " "
+         << (metric.has_baseline ? metric.tolerance : DEFAULT_TOLERANCE) << "\n";
+  }
+}
+
+void writeReport(const std::vector<Metric> & metrics, bool compared)
+{
+  std::ofstream file(PERF_GATE_REPORT_FILE);
+  file << "{\n  \"architecture\": \"" << PERF_GATE_ARCH << "\",\n"
+       << "  \"baseline_file\": \"" << baselinePath() << "\",\n"
+       << "  \"compared\": " << (compared ? "true" : "false") << ",\n  \"metrics\": [\n";
+  for (size_t i = 0; i < metrics.size(); ++i) {
+    const Metric & metric = metrics[i];
+    file << "    {\"name\": \"" << metric.name << "\", \"value\": " << metric.value
+         << ", \"better\": \"" << (metric.better == Better::LOWER ? "lower" : "higher") << "\"";
+    if (metric.has_baseline) {
+      file << ", \"baseline\": " << metric.baseline << ", \"tolerance\": " << metric.tolerance
+           << ", \"limit\": " << metric.limit()
+           << ", \"passed\": " << (metric.passed() ? "true" : "false");
+    }
+    file << "}" << (i + 1 < metrics.size() ? "," : "") << "\n";
+  }
+  file << "  ]\n}\n";
+}
+}  // namespace
+
+class PerformanceGateTest : public ::testing::Test
+{
+protected:
+  static void SetUpTestCase()
+  {
+    MapParameterSource parameters = xboxParameters();
+    MappingConfig config = loadMappingConfig(&parameters);
+    const std::vector<JoySnapshot> session = makeSession();
+
+    TeleopMapper mapper;
+    mapper.configure(config);
+    TeleopCommand command;
+    double checksum = 0.0;
+    double mapping_ns;
+    double mapping_allocations;
+    timeBatches(
+      SESSION_SIZE,
+      [&]() {
+        for (const JoySnapshot & joy : session) {
+          mapper.map(joy, 0.01, &command);
+          checksum += command.chassis[LINEAR_X];
+        }
+      },
+      &mapping_ns, &mapping_allocations);
+
+    std::vector<uint8_t> payload = serializeJoy(session[1]);
+    JoyCdrDecoder decoder;
+    decoder.bind({0, 1, 3, 4, 6, 7}, {4, 5});
+    JoySnapshot decoded;
+    const size_t decodes = 1000;
+    double decode_ns;
+    double decode_allocations;
+    timeBatches(
+      decodes,
+      [&]() {
+        for (size_t i = 0; i < decodes; ++i) {
+          decoder.decode(payload.data(), payload.size(), &decoded);
+          checksum += decoded.axes[1];
+        }
+      },
+      &decode_ns, &decode_allocations);
+    decode_ok_ = decoder.decode(payload.data(), payload.size(), &decoded) &&
+                 decoded.axes[1] == session[1].axes[1] && decoded.buttons[4] == 1;
+
+    // A recorded session through the batch engine, as the offline tools run it.
+    std::vector<float> axes(BATCH_ROWS * 8);
+    std::vector<int32_t> buttons(BATCH_ROWS * 11);
+    std::vector<double> stamps(BATCH_ROWS);
+    for (size_t row = 0; row < BATCH_ROWS; ++row) {
+      const JoySnapshot & joy = session[row % SESSION_SIZE];
+      std::copy_n(joy.axes, 8, &axes[row * 8]);
+      std::copy_n(joy.buttons, 11, &buttons[row * 11]);
+      stamps[row] = 0.01 * static_cast<double>(row);
+    }
+    std::vector<int8_t> profiles(BATCH_ROWS);
+    std::vector<double> chassis(BATCH_ROWS * NUM_CHASSIS_AXES);
+    std::vector<double> joints(BATCH_ROWS * mapper.joints().size());
+    BatchInput input;
+    input.rows = BATCH_ROWS;
+    input.axes = axes.data();
+    input.num_axes = 8;
+    input.axes_stride = 8;
+    input.buttons = buttons.data();
+    input.num_buttons = 11;
+    input.buttons_stride = 11;
+    input.stamps = stamps.data();
+    BatchOutput output;
+    output.profile = profiles.data();
+    output.chassis = chassis.data();
+    output.joints = joints.data();
+    auto start = std::chrono::steady_clock::now();
+    const int batches = 5;
+    for (int i = 0; i < batches; ++i) {
+      mapper.mapBatch(input, output);
+    }
+    double batch_s =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    checksum += chassis.back();
+
+    // A ring of robots near their slots, driving and turning.
+    std::vector<FormationSlot> slots(FORMATION_ROBOTS);
+    for (size_t i = 0; i < FORMATION_ROBOTS; ++i) {
+      double angle = 2.0 * M_PI * static_cast<double>(i) / FORMATION_ROBOTS;
+      slots[i].x = 3.0 * std::cos(angle);
+      slots[i].y = 3.0 * std::sin(angle);
+      slots[i].yaw = angle;
+    }
+    FormationSolver solver;
+    solver.configure(slots, 1.0, 1.0, 0.5, 0.5);
+    const int64_t now_ns = 1000000000;
+    for (size_t i = 0; i < FORMATION_ROBOTS; ++i) {
+      solver.setPose(i, slots[i].x + 0.01 * i, slots[i].y, slots[i].yaw, now_ns);
+    }
+    const size_t solves = 100;
+    double formation_ns;
+    double formation_allocations;
+    timeBatches(
+      solves,
+      [&]() {
+        for (size_t i = 0; i < solves; ++i) {
+          solver.solve(0.5, 0.2, 0.3, 0.0, now_ns, 100000000);
+          checksum += solver.linearX().back();
+        }
+      },
+      &formation_ns, &formation_allocations);
+
+    metrics_ = {
+      {"mapping_ns", Better::LOWER},
+      {"mapping_allocations", Better::LOWER},
+      {"decode_ns", Better::LOWER},
+      {"decode_allocations", Better::LOWER},
+      {"batch_mapping_messages_per_second", Better::HIGHER},
+      {"formation_solve_32_ns", Better::LOWER},
+      {"formation_solve_allocations", Better::LOWER},
+    };
+    metrics_[0].value = mapping_ns;
+    metrics_[1].value = mapping_allocations;
+    metrics_[2].value = decode_ns;
+    metrics_[3].value = decode_allocations;
+    metrics_[4].value = static_cast<double>(batches * BATCH_ROWS) / batch_s;
+    metrics_[5].value = formation_ns;
+    metrics_[6].value = formation_allocations;
+    // Keeps the timed work from being optimized away.
+    EXPECT_TRUE(std::isfinite(checksum));
+
+    loadBaselines(&metrics_);
+    const char * update = std::getenv("PERF_GATE_UPDATE_BASELINE");
+    if (update != nullptr && std::string(update) == "1") {
+      writeBaselines(metrics_);
+    }
+    writeReport(metrics_, PERF_GATE_OPTIMIZED);
+  }
+
+  static void check(const std::string & name)
+  {
+    const Metric * metric = nullptr;
+    for (const Metric & candidate : metrics_) {
+      if (candidate.name == name) {
+        metric = &candidate;
+      }
+    }
+    ASSERT_NE(metric, nullptr);
+    if (!metric->has_baseline) {
+      GTEST_SKIP() << "No " << name << " baseline for " << PERF_GATE_ARCH << " in "
+                   << baselinePath() << ", measured " << metric->value << ".";
+    }
+    // Allocation counts do not depend on the optimization level.
+    if (!PERF_GATE_OPTIMIZED && name.find("allocations") == std::string::npos) {
+      GTEST_SKIP() << "Timings are only compared in Release or RelWithDebInfo builds.";
+    }
+    EXPECT_TRUE(metric->passed()) << name << " " << metric->value << " against baseline "
+                                  << metric->baseline << ", limit " << metric->limit() << ".";
+  }
+
+  static std::vector<Metric> metrics_;
+  static bool decode_ok_;
+};
+
+std::vector<Metric> PerformanceGateTest::metrics_;
+bool PerformanceGateTest::decode_ok_ = false;
+
+TEST_F(PerformanceGateTest, DecodeReadsThePayload) { EXPECT_TRUE(decode_ok_); }
+
+TEST_F(PerformanceGateTest, MappingTime) { check("mapping_ns"); }
+
+TEST_F(PerformanceGateTest, MappingAllocations) { check("mapping_allocations"); }
+
+TEST_F(PerformanceGateTest, DecodeTime) { check("decode_ns"); }
+
+TEST_F(PerformanceGateTest, DecodeAllocations) { check("decode_allocations"); }
+
+TEST_F(PerformanceGateTest, FormationSolveTime) { check("formation_solve_32_ns"); }
+
+TEST_F(PerformanceGateTest, FormationSolveAllocations) { check("formation_solve_allocations"); }
+
+TEST_F(PerformanceGateTest, BatchMappingThroughput) { check("batch_mapping_messages_per_second"); }
+
+}  // namespace pb_teleop_twist_joy
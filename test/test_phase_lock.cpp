@@ -0,0 +1,112 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// PhaseLock against a simulated controller whose ticks jump backwards, as after
+// a simulation reset or a looping bag.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "pb_teleop_twist_joy/phase_lock.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+constexpr int64_t PERIOD_NS = 2000000;
+constexpr int64_t OFFSET_NS = 300000;
+
+// Runs `count` controller periods from `start_ns`, publishing at every target
+// and returning the phase errors seen for the last tick.
+struct Session
+{
+  explicit Session(PhaseLock * lock)
+  : lock(lock) {}
+
+  void run(int64_t start_ns, int count)
+  {
+    matched = 0;
+    for (int i = 0; i < count; ++i) {
+      int64_t tick_ns = start_ns + i * PERIOD_NS;
+      if (lock->onTick(tick_ns, &phase_error_ns)) {
+        ++matched;
+      }
+      int64_t target_ns = lock->nextPublishTime(tick_ns);
+      EXPECT_GT(target_ns, tick_ns);
+      EXPECT_LE(target_ns, tick_ns + PERIOD_NS) << "schedule left behind at tick " << i;
+      lock->notePublished(target_ns);
+    }
+  }
+
+  PhaseLock * lock;
+  int64_t phase_error_ns = 0;
+  int matched = 0;
+};
+}  // namespace
+
+TEST(PhaseLockTest, LocksOnTicks)
+{
+  PhaseLock lock(PERIOD_NS, OFFSET_NS, 1);
+  Session session(&lock);
+  session.run(1000000000, 50);
+  EXPECT_TRUE(lock.locked());
+  EXPECT_GT(session.matched, 40);
+  EXPECT_EQ(session.phase_error_ns, 0);
+}
+
+TEST(PhaseLockTest, TicksJumpBackwards)
+{
+  PhaseLock lock(PERIOD_NS, OFFSET_NS, 1);
+  Session session(&lock);
+  session.run(5000000000, 50);
+  ASSERT_GT(session.matched, 40);
+
+  // The controller restarts at time zero plus a bit, far behind the lock.
+  session.run(100000000, 50);
+  EXPECT_EQ(lock.resets(), 1u);
+  EXPECT_TRUE(lock.locked());
+  EXPECT_GT(session.matched, 40);
+  EXPECT_EQ(session.phase_error_ns, 0);
+}
+
+TEST(PhaseLockTest, ResetDropsSchedule)
+{
+  PhaseLock lock(PERIOD_NS, OFFSET_NS, 1);
+  Session session(&lock);
+  session.run(5000000000, 10);
+  ASSERT_GT(lock.nextPublishTime(5000000000 + 10 * PERIOD_NS), 5000000000);
+
+  // What the clock jump handler does before the first tick of the new timeline.
+  lock.reset();
+  EXPECT_FALSE(lock.locked());
+  int64_t target_ns = lock.nextPublishTime(100000000);
+  EXPECT_GT(target_ns, 100000000);
+  EXPECT_LE(target_ns, 100000000 + PERIOD_NS);
+}
+
+TEST(PhaseLockTest, ReorderedTickKeepsLock)
+{
+  PhaseLock lock(PERIOD_NS, OFFSET_NS, 1);
+  Session session(&lock);
+  session.run(1000000000, 10);
+  int64_t phase_error_ns = 0;
+  // A late duplicate within a period is ignored without dropping the lock.
+  EXPECT_FALSE(lock.onTick(1000000000 + 8 * PERIOD_NS, &phase_error_ns));
+  EXPECT_EQ(lock.resets(), 0u);
+  EXPECT_TRUE(lock.locked());
+}
+
+}  // namespace pb_teleop_twist_joy
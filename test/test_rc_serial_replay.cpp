@@ -0,0 +1,304 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Replays DBUS and SBUS byte streams through a pseudo-terminal into
+// RcSerialPort and RcFrameDecoder, read and resynchronized on line gaps the way
+// the node's reader thread does it.
+
+#include <gtest/gtest.h>
+#include <pty.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pb_teleop_twist_joy/rc_frame_decoder.hpp"
+#include "pb_teleop_twist_joy/rc_serial_port.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+using Bytes = std::vector<uint8_t>;
+
+// Frames are sent this far apart, above the 3 ms gap that delimits them.
+constexpr auto FRAME_PERIOD = std::chrono::milliseconds(7);
+constexpr auto FRAME_GAP = std::chrono::milliseconds(3);
+
+constexpr int DBUS_MIN = 364;
+constexpr int DBUS_CENTER = 1024;
+constexpr int DBUS_MAX = 1684;
+constexpr int SBUS_MIN = 172;
+constexpr int SBUS_CENTER = 992;
+constexpr int SBUS_MAX = 1812;
+constexpr uint8_t SBUS_FRAME_LOST = 0x04;
+constexpr uint8_t SBUS_FAILSAFE = 0x08;
+
+// Switch positions on the wire.
+constexpr int SWITCH_UP = 1;
+constexpr int SWITCH_MIDDLE = 3;
+constexpr int SWITCH_DOWN = 2;
+
+Bytes dbusFrame(
+  const int (&channels)[4], int left_switch, int right_switch, int16_t mouse_x, uint16_t keys)
+{
+  // Four 11 bit channels, then the right and left switch, packed LSB first.
+  uint64_t bits =
+    static_cast<uint64_t>(right_switch) << 44 | static_cast<uint64_t>(left_switch) << 46;
+  for (size_t i = 0; i < 4; ++i) {
+    bits |= static_cast<uint64_t>(channels[i]) << (11 * i);
+  }
+  Bytes frame(18, 0);
+  for (size_t i = 0; i < 6; ++i) {
+    frame[i] = static_cast<uint8_t>(bits >> (8 * i));
+  }
+  frame[6] = static_cast<uint8_t>(mouse_x);
+  frame[7] = static_cast<uint8_t>(static_cast<uint16_t>(mouse_x) >> 8);
+  frame[14] = static_cast<uint8_t>(keys);
+  frame[15] = static_cast<uint8_t>(keys >> 8);
+  return frame;
+}
+
+Bytes sbusFrame(int first_channel, int fifth_channel, uint8_t flags)
+{
+  int channels[16];
+  std::fill(channels, channels + 16, SBUS_CENTER);
+  channels[0] = first_channel;
+  channels[4] = fifth_channel;
+  Bytes frame(25, 0);
+  frame[0] = 0x0F;
+  uint32_t bits = 0;
+  int num_bits = 0;
+  size_t byte = 1;
+  for (int channel : channels) {
+    bits |= static_cast<uint32_t>(channel) << num_bits;
+    num_bits += 11;
+    while (num_bits >= 8) {
+      frame[byte++] = static_cast<uint8_t>(bits);
+      bits >>= 8;
+      num_bits -= 8;
+    }
+  }
+  frame[23] = flags;
+  return frame;
+}
+
+// Writes each chunk to the master side of a pty, one frame period apart, and
+// collects what the port and decoder on the slave side make of them.
+class PtyReplay
+{
+public:
+  ~PtyReplay()
+  {
+    if (master_ >= 0) {
+      ::close(master_);
+      ::close(slave_);
+    }
+  }
+
+  bool open()
+  {
+    char name[256];
+    if (openpty(&master_, &slave_, name, nullptr, nullptr) != 0) {
+      return false;
+    }
+    slave_name_ = name;
+    return true;
+  }
+
+  const std::string & slaveName() const { return slave_name_; }
+
+  std::vector<JoySnapshot> replay(
+    RcSerialPort * port, RcFrameDecoder * decoder, const std::vector<Bytes> & chunks)
+  {
+    std::thread writer([this, &chunks]() {
+      for (const Bytes & chunk : chunks) {
+        std::this_thread::sleep_for(FRAME_PERIOD);
+        EXPECT_EQ(::write(master_, chunk.data(), chunk.size()), static_cast<ssize_t>(chunk.size()))
+          << std::strerror(errno);
+      }
+      std::this_thread::sleep_for(FRAME_PERIOD);
+    });
+
+    std::vector<JoySnapshot> decoded;
+    uint8_t buffer[256];
+    JoySnapshot joy;
+    auto last_byte_time = std::chrono::steady_clock::now();
+    const auto end = last_byte_time + FRAME_PERIOD * (chunks.size() + 2) + std::chrono::seconds(2);
+    size_t received = 0;
+    size_t expected = 0;
+    for (const Bytes & chunk : chunks) {
+      expected += chunk.size();
+    }
+    while (received < expected && std::chrono::steady_clock::now() < end) {
+      ssize_t count = port->read(buffer, sizeof(buffer), 10);
+      auto now = std::chrono::steady_clock::now();
+      EXPECT_GE(count, 0) << std::strerror(errno);
+      if (count <= 0) {
+        continue;
+      }
+      if (now - last_byte_time > FRAME_GAP) {
+        decoder->resync();
+      }
+      last_byte_time = now;
+      received += static_cast<size_t>(count);
+      for (ssize_t i = 0; i < count; ++i) {
+        if (decoder->push(buffer[i], &joy)) {
+          decoded.push_back(joy);
+        }
+      }
+    }
+    writer.join();
+    EXPECT_EQ(received, expected);
+    return decoded;
+  }
+
+private:
+  int master_ = -1;
+  int slave_ = -1;
+  std::string slave_name_;
+};
+
+class RcSerialReplayTest : public ::testing::Test
+{
+protected:
+  void open(RcProtocol protocol)
+  {
+    if (!pty_.open()) {
+      GTEST_SKIP() << "openpty: " << std::strerror(errno);
+    }
+    std::string error;
+    ASSERT_TRUE(port_.open(pty_.slaveName(), protocol, &error)) << error;
+  }
+
+  PtyReplay pty_;
+  RcSerialPort port_;
+};
+
+bool released(const JoySnapshot & joy)
+{
+  for (uint32_t i = 0; i < joy.num_axes; ++i) {
+    if (joy.axes[i] != 0.0f) {
+      return false;
+    }
+  }
+  for (uint32_t i = 0; i < joy.num_buttons; ++i) {
+    if (joy.buttons[i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+TEST_F(RcSerialReplayTest, Dbus)
+{
+  open(RcProtocol::DBUS);
+  if (IsSkipped()) {
+    return;
+  }
+  RcFrameDecoder decoder(RcProtocol::DBUS);
+
+  const Bytes center =
+    dbusFrame({DBUS_CENTER, DBUS_CENTER, DBUS_CENTER, DBUS_CENTER}, SWITCH_MIDDLE, SWITCH_UP, 0, 0);
+  const Bytes driving =
+    dbusFrame({DBUS_MAX, DBUS_CENTER, DBUS_CENTER, DBUS_MIN}, SWITCH_UP, SWITCH_DOWN, -120, 0x0011);
+  Bytes corrupt = center;
+  // Both switches in the invalid position 0.
+  corrupt[5] &= 0x0F;
+  // The port is opened in the middle of a frame, the bytes run on into the
+  // next one without a gap.
+  Bytes joined(center.begin() + 11, center.end());
+  joined.insert(joined.end(), center.begin(), center.end());
+
+  std::vector<JoySnapshot> decoded =
+    pty_.replay(&port_, &decoder, {joined, center, driving, corrupt, driving, center});
+
+  ASSERT_EQ(decoded.size(), 4u);
+  EXPECT_EQ(decoder.invalidFrames(), 2u);
+
+  EXPECT_EQ(decoded[0].num_axes, 8u);
+  EXPECT_EQ(decoded[0].num_buttons, 24u);
+  EXPECT_FLOAT_EQ(decoded[0].axes[0], 0.0f);
+  EXPECT_EQ(decoded[0].buttons[1], 1);
+  EXPECT_EQ(decoded[0].buttons[3], 1);
+
+  for (size_t i : {1u, 2u}) {
+    SCOPED_TRACE("frame " + std::to_string(i));
+    EXPECT_FLOAT_EQ(decoded[i].axes[0], 1.0f);
+    EXPECT_FLOAT_EQ(decoded[i].axes[1], 0.0f);
+    EXPECT_FLOAT_EQ(decoded[i].axes[3], -1.0f);
+    EXPECT_FLOAT_EQ(decoded[i].axes[5], -120.0f);
+    EXPECT_EQ(decoded[i].buttons[0], 1);
+    EXPECT_EQ(decoded[i].buttons[5], 1);
+    // W and Shift.
+    EXPECT_EQ(decoded[i].buttons[8], 1);
+    EXPECT_EQ(decoded[i].buttons[12], 1);
+    EXPECT_EQ(decoded[i].buttons[9], 0);
+  }
+  EXPECT_FLOAT_EQ(decoded[3].axes[3], 0.0f);
+}
+
+TEST_F(RcSerialReplayTest, Sbus)
+{
+  open(RcProtocol::SBUS);
+  if (IsSkipped()) {
+    return;
+  }
+  RcFrameDecoder decoder(RcProtocol::SBUS);
+
+  const Bytes driving = sbusFrame(SBUS_MAX, SBUS_MIN, 0x00);
+  const Bytes lost = sbusFrame(SBUS_MAX, SBUS_MIN, SBUS_FRAME_LOST);
+  const Bytes failsafe = sbusFrame(SBUS_CENTER, SBUS_CENTER, SBUS_FRAME_LOST | SBUS_FAILSAFE);
+
+  // Noise before the first header, a single lost frame, a run of lost frames
+  // long enough to release, recovery, then failsafe.
+  std::vector<Bytes> chunks = {{0x00, 0x3C, 0x0F, 0x11}, driving, lost, driving};
+  for (uint32_t i = 0; i < RcFrameDecoder::MAX_LOST_FRAMES; ++i) {
+    chunks.push_back(lost);
+  }
+  chunks.push_back(driving);
+  chunks.push_back(failsafe);
+
+  std::vector<JoySnapshot> decoded = pty_.replay(&port_, &decoder, chunks);
+
+  ASSERT_EQ(decoded.size(), chunks.size() - 1);
+  auto expectDriving = [](const JoySnapshot & joy) {
+    EXPECT_EQ(joy.num_axes, 16u);
+    EXPECT_FLOAT_EQ(joy.axes[0], 1.0f);
+    EXPECT_FLOAT_EQ(joy.axes[1], 0.0f);
+    EXPECT_FLOAT_EQ(joy.axes[4], -1.0f);
+    // Channel 5 low.
+    EXPECT_EQ(joy.buttons[2], 1);
+    EXPECT_EQ(joy.buttons[3], 0);
+  };
+  for (size_t i = 0; i < decoded.size(); ++i) {
+    SCOPED_TRACE("frame " + std::to_string(i));
+    if (i == RcFrameDecoder::MAX_LOST_FRAMES + 2 || i == decoded.size() - 1) {
+      // The last lost frame of the run, and failsafe.
+      EXPECT_TRUE(released(decoded[i]));
+    } else {
+      expectDriving(decoded[i]);
+    }
+  }
+}
+
+}  // namespace pb_teleop_twist_joy
@@ -0,0 +1,155 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// RuntimeStateFile across simulated restarts: slot fallback after a torn or
+// corrupted write, and rejection of states from another boot or another set of
+// joints. Damage is done by writing into the file at the offsets of version 1.
+
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "pb_teleop_twist_joy/runtime_state_file.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+// magic, version, joints_hash, then the boot id.
+constexpr off_t BOOT_ID_OFFSET = 16;
+constexpr off_t SLOTS_OFFSET = BOOT_ID_OFFSET + 40;
+// sequence, saved_ns, profile, num_joints, joints, checksum.
+constexpr off_t SLOT_SIZE = 8 + 8 + 4 + 4 + 8 * RuntimeStateFile::MAX_JOINTS + 8;
+constexpr off_t SLOT_JOINTS_OFFSET = 24;
+constexpr int64_t MAX_AGE_NS = 60000000000;
+
+const std::vector<std::string> JOINTS = {"gimbal_pitch_joint", "gimbal_yaw_joint"};
+
+class RuntimeStateFileTest : public ::testing::Test
+{
+protected:
+  void SetUp() override
+  {
+    path_ = ::testing::TempDir() + "pb_teleop_state_" + std::to_string(::getpid()) + "_" +
+            ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    std::remove(path_.c_str());
+  }
+
+  void TearDown() override { std::remove(path_.c_str()); }
+
+  // Saves `count` states, the i-th with joints {i, -i}, as one node run.
+  void saveStates(int count)
+  {
+    RuntimeStateFile file;
+    std::string error;
+    ASSERT_TRUE(file.open(path_, JOINTS, &error)) << error;
+    for (int i = 1; i <= count; ++i) {
+      file.save({static_cast<double>(i), -static_cast<double>(i)}, SpeedProfile::NORMAL);
+    }
+  }
+
+  // Restores as a restarted node with `joints` would.
+  bool restore(std::vector<double> * positions, const std::vector<std::string> & joints = JOINTS)
+  {
+    RuntimeStateFile file;
+    std::string error;
+    EXPECT_TRUE(file.open(path_, joints, &error)) << error;
+    SpeedProfile profile = SpeedProfile::DISABLED;
+    return file.restore(MAX_AGE_NS, positions, &profile);
+  }
+
+  void overwrite(off_t offset, const std::string & bytes)
+  {
+    int fd = ::open(path_.c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    EXPECT_EQ(::pwrite(fd, bytes.data(), bytes.size(), offset), static_cast<ssize_t>(bytes.size()));
+    ::close(fd);
+  }
+
+  // Slot written by the `sequence`-th save since the file was created.
+  static off_t slotOffset(int sequence) { return SLOTS_OFFSET + (sequence % 2) * SLOT_SIZE; }
+
+  std::string path_;
+};
+}  // namespace
+
+TEST_F(RuntimeStateFileTest, RestoresNewestState)
+{
+  saveStates(3);
+  std::vector<double> positions;
+  ASSERT_TRUE(restore(&positions));
+  EXPECT_EQ(positions, (std::vector<double>{3.0, -3.0}));
+}
+
+TEST_F(RuntimeStateFileTest, FallsBackToOtherSlotWhenNewestIsCorrupted)
+{
+  saveStates(3);
+  // A torn write of the newest slot: payload changed, checksum not.
+  overwrite(slotOffset(3) + SLOT_JOINTS_OFFSET, "torn");
+  std::vector<double> positions;
+  ASSERT_TRUE(restore(&positions));
+  EXPECT_EQ(positions, (std::vector<double>{2.0, -2.0}));
+}
+
+TEST_F(RuntimeStateFileTest, IgnoresCorruptedOlderSlot)
+{
+  saveStates(3);
+  overwrite(slotOffset(2) + SLOT_JOINTS_OFFSET, "torn");
+  std::vector<double> positions;
+  ASSERT_TRUE(restore(&positions));
+  EXPECT_EQ(positions, (std::vector<double>{3.0, -3.0}));
+}
+
+TEST_F(RuntimeStateFileTest, NothingWhenBothSlotsAreCorrupted)
+{
+  saveStates(3);
+  overwrite(slotOffset(2) + SLOT_JOINTS_OFFSET, "torn");
+  overwrite(slotOffset(3) + SLOT_JOINTS_OFFSET, "torn");
+  std::vector<double> positions;
+  EXPECT_FALSE(restore(&positions));
+}
+
+TEST_F(RuntimeStateFileTest, RejectsStateOfAnotherBoot)
+{
+  saveStates(2);
+  overwrite(BOOT_ID_OFFSET, "00000000-0000-0000-0000-000000000000\n");
+  std::vector<double> positions;
+  EXPECT_FALSE(restore(&positions));
+
+  // The next save starts over in this boot and no old state comes back.
+  saveStates(1);
+  ASSERT_TRUE(restore(&positions));
+  EXPECT_EQ(positions, (std::vector<double>{1.0, -1.0}));
+}
+
+TEST_F(RuntimeStateFileTest, RejectsStateOfOtherJoints)
+{
+  saveStates(2);
+  std::vector<double> positions;
+  EXPECT_FALSE(restore(&positions, {"gimbal_yaw_joint", "gimbal_pitch_joint"}));
+  EXPECT_FALSE(restore(&positions, {"gimbal_pitch_joint"}));
+  // The names are hashed with their terminators, so a different split of the
+  // same characters does not collide.
+  EXPECT_FALSE(restore(&positions, {"gimbal_pitch_jointg", "imbal_yaw_joint"}));
+  ASSERT_TRUE(restore(&positions));
+  EXPECT_EQ(positions, (std::vector<double>{2.0, -2.0}));
+}
+
+}  // namespace pb_teleop_twist_joy
@@ -0,0 +1,200 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Replays one scripted joy session twice under use_sim_time, once with /clock
+// at real time and once 100 times faster, and checks both produce the same
+// commands. Half the session carries joy stamps, half is integrated on the
+// node clock, so both time sources are covered.
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "geometry_msgs/msg/twist.hpp"
+#include "pb_teleop_twist_joy/pb_teleop_twist_joy.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "rosgraph_msgs/msg/clock.hpp"
+#include "sensor_msgs/msg/joint_state.hpp"
+#include "sensor_msgs/msg/joy.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+constexpr int64_t START_NS = 1000000000000;
+constexpr int64_t STEP_NS = 10000000;
+constexpr int NUM_STEPS = 300;
+// Steps [GAP_BEGIN, GAP_END) send no joy while the clock runs on.
+constexpr int GAP_BEGIN = 100;
+constexpr int GAP_END = 110;
+// From here on joy is unstamped and integrated on the node clock.
+constexpr int UNSTAMPED_BEGIN = 150;
+constexpr int RELEASE_STEPS[2] = {160, 220};
+constexpr int TURBO_BEGIN = 200;
+constexpr int TURBO_END = 260;
+
+struct Output
+{
+  double linear_x = 0.0;
+  double linear_y = 0.0;
+  double angular_z = 0.0;
+  std::vector<double> joints;
+};
+
+template <typename Predicate>
+bool spinUntil(rclcpp::Executor * executor, Predicate done)
+{
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  while (!done()) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    executor->spin_once(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+bool released(int step)
+{
+  return step == RELEASE_STEPS[0] || step == RELEASE_STEPS[1];
+}
+
+sensor_msgs::msg::Joy sessionJoy(int step)
+{
+  sensor_msgs::msg::Joy joy_msg;
+  joy_msg.axes.resize(8);
+  joy_msg.buttons.resize(11);
+  double k = static_cast<double>(step);
+  joy_msg.axes[0] = static_cast<float>(std::sin(0.05 * k));
+  joy_msg.axes[1] = static_cast<float>(std::cos(0.03 * k));
+  joy_msg.axes[3] = static_cast<float>(0.5 * std::sin(0.02 * k));
+  joy_msg.axes[4] = static_cast<float>(-0.7 * std::cos(0.04 * k));
+  joy_msg.axes[6] = step % 50 < 25 ? 1.0f : 0.0f;
+  joy_msg.buttons[4] = released(step) ? 0 : 1;
+  joy_msg.buttons[5] = step >= TURBO_BEGIN && step < TURBO_END ? 1 : 0;
+  if (step < UNSTAMPED_BEGIN) {
+    joy_msg.header.stamp = rclcpp::Time(START_NS + step * STEP_NS, RCL_ROS_TIME);
+  }
+  return joy_msg;
+}
+
+// Runs the session with `wall_step` of wall time per simulated step. Outputs
+// are collected per processed joy message.
+std::vector<Output> replay(std::chrono::nanoseconds wall_step)
+{
+  rclcpp::NodeOptions options;
+  options.arguments(
+    {"--ros-args", "-r", "__node:=pb_teleop_twist_joy", "--params-file", TEST_CONFIG_FILE});
+  options.append_parameter_override("use_sim_time", true);
+  auto teleop_node = std::make_shared<TeleopTwistJoyNode>(options);
+  auto driver_node = std::make_shared<rclcpp::Node>("sim_time_replay_driver");
+  auto clock_pub =
+    driver_node->create_publisher<rosgraph_msgs::msg::Clock>("/clock", rclcpp::ClockQoS());
+  auto joy_pub = driver_node->create_publisher<sensor_msgs::msg::Joy>("joy", 10);
+  std::vector<geometry_msgs::msg::Twist> twists;
+  std::vector<std::vector<double>> joints;
+  auto cmd_vel_sub = driver_node->create_subscription<geometry_msgs::msg::Twist>(
+    "cmd_vel", 10,
+    [&twists](const geometry_msgs::msg::Twist::SharedPtr msg) { twists.push_back(*msg); });
+  auto joint_sub = driver_node->create_subscription<sensor_msgs::msg::JointState>(
+    "cmd_gimbal_joint", 10, [&joints](const sensor_msgs::msg::JointState::SharedPtr msg) {
+      joints.push_back(msg->position);
+    });
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(teleop_node);
+  executor.add_node(driver_node);
+  bool connected = spinUntil(&executor, [&]() {
+    return joy_pub->get_subscription_count() > 0 && cmd_vel_sub->get_publisher_count() > 0 &&
+           joint_sub->get_publisher_count() > 0 && clock_pub->get_subscription_count() > 0;
+  });
+  EXPECT_TRUE(connected) << "The teleop node did not connect.";
+
+  std::vector<Output> outputs;
+  auto wall_start = std::chrono::steady_clock::now();
+  for (int step = 0; step < NUM_STEPS && connected; ++step) {
+    std::this_thread::sleep_until(wall_start + step * wall_step);
+    int64_t now_ns = START_NS + step * STEP_NS;
+    rosgraph_msgs::msg::Clock clock_msg;
+    clock_msg.clock = rclcpp::Time(now_ns, RCL_ROS_TIME);
+    clock_pub->publish(clock_msg);
+    if (!spinUntil(&executor, [&]() { return teleop_node->now().nanoseconds() == now_ns; })) {
+      ADD_FAILURE() << "The node clock did not follow /clock at step " << step << ".";
+      break;
+    }
+    if (step >= GAP_BEGIN && step < GAP_END) {
+      continue;
+    }
+
+    // Every joy gives a twist, the release a zero one and no joints.
+    size_t num_twists = twists.size() + 1;
+    size_t num_joints = joints.size() + (released(step) ? 0 : 1);
+    joy_pub->publish(sessionJoy(step));
+    bool answered = spinUntil(
+      &executor, [&]() { return twists.size() >= num_twists && joints.size() >= num_joints; });
+    if (!answered) {
+      ADD_FAILURE() << "No command for the joy of step " << step << ".";
+      break;
+    }
+    Output output;
+    output.linear_x = twists.back().linear.x;
+    output.linear_y = twists.back().linear.y;
+    output.angular_z = twists.back().angular.z;
+    output.joints = joints.back();
+    outputs.push_back(output);
+  }
+  return outputs;
+}
+}  // namespace
+
+class SimTimeReplayTest : public ::testing::Test
+{
+protected:
+  static void SetUpTestCase() { rclcpp::init(0, nullptr); }
+  static void TearDownTestCase() { rclcpp::shutdown(); }
+};
+
+TEST_F(SimTimeReplayTest, AcceleratedClockMatchesRealTime)
+{
+  std::vector<Output> real_time = replay(std::chrono::milliseconds(10));
+  std::vector<Output> accelerated = replay(std::chrono::microseconds(100));
+
+  const size_t expected = NUM_STEPS - (GAP_END - GAP_BEGIN);
+  ASSERT_EQ(real_time.size(), expected);
+  ASSERT_EQ(accelerated.size(), expected);
+  for (size_t i = 0; i < expected; ++i) {
+    SCOPED_TRACE("output " + std::to_string(i));
+    EXPECT_DOUBLE_EQ(real_time[i].linear_x, accelerated[i].linear_x);
+    EXPECT_DOUBLE_EQ(real_time[i].linear_y, accelerated[i].linear_y);
+    EXPECT_DOUBLE_EQ(real_time[i].angular_z, accelerated[i].angular_z);
+    ASSERT_EQ(real_time[i].joints.size(), accelerated[i].joints.size());
+    for (size_t j = 0; j < real_time[i].joints.size(); ++j) {
+      EXPECT_DOUBLE_EQ(real_time[i].joints[j], accelerated[i].joints[j]);
+    }
+  }
+
+  // Equal outputs only mean something if the session moved the integrators.
+  bool moved = false;
+  for (double position : accelerated.back().joints) {
+    moved = moved || std::abs(position) > 1e-3;
+  }
+  EXPECT_TRUE(moved);
+}
+
+}  // namespace pb_teleop_twist_joy
@@ -0,0 +1,269 @@
+# Copyright 2025 Lihan Chen
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""End-to-end latency from a uinput gamepad through joy_node to the commands.
+
+A virtual Xbox pad is created on /dev/uinput before joy_node starts. Its axes
+and buttons enumerate in the order of config/xbox.config.yaml. The test holds
+the enable button, steps the left stick and the right stick and measures the
+time from writing the kernel event until cmd_vel and cmd_gimbal_joint follow.
+It is skipped when uinput cannot be opened or its event device is unreadable.
+"""
+
+import fcntl
+import glob
+import os
+import struct
+import time
+import unittest
+
+from ament_index_python.packages import get_package_share_directory
+from geometry_msgs.msg import Twist
+import launch
+import launch_ros.actions
+import launch_testing.actions
+import pytest
+import rclpy
+from sensor_msgs.msg import JointState
+
+DEVICE_NAME = "pb_teleop_twist_joy uinput test pad"
+STEPS = 50
+# Generous, the bound catches a broken path rather than a slow machine.
+LATENCY_LIMIT = 0.1
+
+# linux/uinput.h and linux/input-event-codes.h
+UI_SET_EVBIT = 0x40045564
+UI_SET_KEYBIT = 0x40045565
+UI_SET_ABSBIT = 0x40045567
+UI_DEV_SETUP = 0x405C5503
+UI_ABS_SETUP = 0x401C5504
+UI_DEV_CREATE = 0x5501
+UI_DEV_DESTROY = 0x5502
+UI_GET_SYSNAME_64 = 0x8040552C
+EV_SYN = 0x00
+EV_KEY = 0x01
+EV_ABS = 0x03
+SYN_REPORT = 0
+BUS_USB = 0x03
+ABS_X, ABS_Y, ABS_Z, ABS_RX, ABS_RY, ABS_RZ = 0x00, 0x01, 0x02, 0x03, 0x04, 0x05
+ABS_HAT0X, ABS_HAT0Y = 0x10, 0x11
+BTN_SOUTH, BTN_EAST, BTN_NORTH, BTN_WEST = 0x130, 0x131, 0x133, 0x134
+BTN_TL, BTN_TR, BTN_SELECT, BTN_START = 0x136, 0x137, 0x13A, 0x13B
+BTN_MODE, BTN_THUMBL, BTN_THUMBR = 0x13C, 0x13D, 0x13E
+
+STICKS = (ABS_X, ABS_Y, ABS_Z, ABS_RX, ABS_RY, ABS_RZ)
+HATS = (ABS_HAT0X, ABS_HAT0Y)
+BUTTONS = (
+    BTN_SOUTH,
+    BTN_EAST,
+    BTN_NORTH,
+    BTN_WEST,
+    BTN_TL,
+    BTN_TR,
+    BTN_SELECT,
+    BTN_START,
+    BTN_MODE,
+    BTN_THUMBL,
+    BTN_THUMBR,
+)
+
+
+class VirtualPad:
+    """Xbox 360 style gamepad on /dev/uinput."""
+
+    def __init__(self):
+        self.fd = os.open("/dev/uinput", os.O_WRONLY | os.O_NONBLOCK)
+        try:
+            fcntl.ioctl(self.fd, UI_SET_EVBIT, EV_KEY)
+            for button in BUTTONS:
+                fcntl.ioctl(self.fd, UI_SET_KEYBIT, button)
+            fcntl.ioctl(self.fd, UI_SET_EVBIT, EV_ABS)
+            for axis in STICKS + HATS:
+                fcntl.ioctl(self.fd, UI_SET_ABSBIT, axis)
+                limit = 1 if axis in HATS else 32767
+                # struct uinput_abs_setup: code, value, min, max, fuzz, flat, res
+                absinfo = struct.pack("Hxxiiiiii", axis, 0, -limit, limit, 0, 0, 0)
+                fcntl.ioctl(self.fd, UI_ABS_SETUP, absinfo)
+            # struct uinput_setup: input_id, name[80], ff_effects_max
+            setup = struct.pack(
+                "HHHH80sI", BUS_USB, 0x045E, 0x028E, 0x0110, DEVICE_NAME.encode(), 0
+            )
+            fcntl.ioctl(self.fd, UI_DEV_SETUP, setup)
+            fcntl.ioctl(self.fd, UI_DEV_CREATE)
+        except OSError:
+            os.close(self.fd)
+            raise
+
+    def event_device(self):
+        sysname = bytearray(64)
+        fcntl.ioctl(self.fd, UI_GET_SYSNAME_64, sysname)
+        sysname = sysname.split(b"\0", 1)[0].decode()
+        for _ in range(100):
+            events = glob.glob(f"/sys/devices/virtual/input/{sysname}/event*")
+            if events:
+                return os.path.join("/dev/input", os.path.basename(events[0]))
+            time.sleep(0.01)
+        return None
+
+    def emit(self, events):
+        """Write (type, code, value) events and a SYN_REPORT, return the write time."""
+        payload = b"".join(
+            struct.pack("llHHi", 0, 0, type_, code, value)
+            for type_, code, value in list(events) + [(EV_SYN, SYN_REPORT, 0)]
+        )
+        now = time.monotonic()
+        os.write(self.fd, payload)
+        return now
+
+    def close(self):
+        fcntl.ioctl(self.fd, UI_DEV_DESTROY)
+        os.close(self.fd)
+
+
+def open_pad():
+    try:
+        pad = VirtualPad()
+    except OSError as e:
+        return None, f"/dev/uinput unavailable: {e}"
+    device = pad.event_device()
+    if device is None or not os.access(device, os.R_OK):
+        pad.close()
+        return None, f"event device {device} of the virtual pad is not readable"
+    return pad, None
+
+
+PAD, SKIP_REASON = None, None
+
+
+@pytest.mark.launch_test
+def generate_test_description():
+    global PAD, SKIP_REASON
+    PAD, SKIP_REASON = open_pad()
+    if PAD is None:
+        return launch.LaunchDescription([launch_testing.actions.ReadyToTest()])
+
+    joy_node = launch_ros.actions.Node(
+        package="joy",
+        executable="joy_node",
+        name="joy_node",
+        parameters=[
+            {
+                "device_name": DEVICE_NAME,
+                "deadzone": 0.05,
+                "autorepeat_rate": 0.0,
+            }
+        ],
+    )
+    teleop_twist_joy_node = launch_ros.actions.Node(
+        package="pb_teleop_twist_joy",
+        executable="pb_teleop_twist_joy_node",
+        name="pb_teleop_twist_joy",
+        parameters=[
+            os.path.join(
+                get_package_share_directory("pb_teleop_twist_joy"),
+                "config",
+                "xbox.config.yaml",
+            )
+        ],
+    )
+    return launch.LaunchDescription(
+        [joy_node, teleop_twist_joy_node, launch_testing.actions.ReadyToTest()]
+    )
+
+
+def percentile(samples, fraction):
+    ordered = sorted(samples)
+    return ordered[min(len(ordered) - 1, int(fraction * len(ordered)))]
+
+
+class TestUinputLatency(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        if PAD is None:
+            raise unittest.SkipTest(SKIP_REASON)
+        rclpy.init()
+        cls.node = rclpy.create_node("uinput_latency_probe")
+        cls.twist = None
+        cls.yaw = None
+        cls.node.create_subscription(Twist, "cmd_vel", cls.on_twist, 10)
+        cls.node.create_subscription(JointState, "cmd_gimbal_joint", cls.on_joint, 10)
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.node.destroy_node()
+        rclpy.shutdown()
+        PAD.close()
+
+    @classmethod
+    def on_twist(cls, msg):
+        cls.twist = msg
+
+    @classmethod
+    def on_joint(cls, msg):
+        if "gimbal_yaw_joint" in msg.name:
+            cls.yaw = msg.position[msg.name.index("gimbal_yaw_joint")]
+
+    def wait_for(self, condition, timeout=5.0):
+        """Spin until condition() holds, return the time it did or None."""
+        end = time.monotonic() + timeout
+        while time.monotonic() < end:
+            if condition():
+                return time.monotonic()
+            rclpy.spin_once(self.node, timeout_sec=0.001)
+        return None
+
+    def report(self, name, latencies):
+        print(
+            f"{name}: n={len(latencies)} "
+            f"p50={percentile(latencies, 0.5) * 1e3:.2f} ms "
+            f"p90={percentile(latencies, 0.9) * 1e3:.2f} ms "
+            f"p99={percentile(latencies, 0.99) * 1e3:.2f} ms "
+            f"max={max(latencies) * 1e3:.2f} ms"
+        )
+        self.assertLess(percentile(latencies, 0.5), LATENCY_LIMIT)
+
+    def test_latency(self):
+        # Enable held, sticks centered: the node publishes a zero twist.
+        cls = type(self)
+        PAD.emit([(EV_KEY, BTN_TL, 1)])
+        started = self.wait_for(
+            lambda: cls.twist is not None and cls.yaw is not None, timeout=15.0
+        )
+        self.assertIsNotNone(started, "no command for the virtual pad")
+
+        chassis = []
+        for _ in range(STEPS):
+            sent = PAD.emit([(EV_ABS, ABS_Y, -32767)])
+            seen = self.wait_for(lambda: abs(cls.twist.linear.x) > 1.0)
+            self.assertIsNotNone(seen, "cmd_vel did not follow the left stick")
+            chassis.append(seen - sent)
+            sent = PAD.emit([(EV_ABS, ABS_Y, 0)])
+            seen = self.wait_for(lambda: abs(cls.twist.linear.x) < 0.1)
+            self.assertIsNotNone(seen, "cmd_vel did not follow the stick release")
+            chassis.append(seen - sent)
+        self.report("cmd_vel", chassis)
+
+        gimbal = []
+        for direction in (1, -1) * (STEPS // 2):
+            before = cls.yaw
+            sent = PAD.emit([(EV_ABS, ABS_RX, direction * 32767)])
+            seen = self.wait_for(lambda: cls.yaw != before)
+            self.assertIsNotNone(seen, "cmd_gimbal_joint did not follow the stick")
+            gimbal.append(seen - sent)
+            PAD.emit([(EV_ABS, ABS_RX, 0)])
+            # Let the release through so the next step starts from rest.
+            self.wait_for(lambda: False, timeout=0.05)
+        self.report("cmd_gimbal_joint", gimbal)
+
+        PAD.emit([(EV_KEY, BTN_TL, 0)])
@@ -0,0 +1,49 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "allocation_counter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+std::atomic<uint64_t> allocations(0);
+}  // namespace
+
+// Not inlined, GCC would take the malloc() and free() inside for a mismatch
+// with the new and delete expressions using them.
+__attribute__((noinline)) void * operator new(size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void * memory = std::malloc(size == 0 ? 1 : size)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void * memory) noexcept { std::free(memory); }
+
+__attribute__((noinline)) void operator delete(void * memory, size_t) noexcept
+{
+  std::free(memory);
+}
+
+namespace pb_teleop_twist_joy
+{
+
+uint64_t allocationCount() { return allocations.load(std::memory_order_relaxed); }
+
+}  // namespace pb_teleop_twist_joy
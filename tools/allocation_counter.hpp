@@ -0,0 +1,30 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLOCATION_COUNTER_HPP_
+#define ALLOCATION_COUNTER_HPP_
+
+#include <cstdint>
+
+namespace pb_teleop_twist_joy
+{
+
+// Number of operator new calls in this process so far. Linking
+// allocation_counter.cpp replaces the global operator new and delete, so it
+// only goes into benchmarks and tests.
+uint64_t allocationCount();
+
+}  // namespace pb_teleop_twist_joy
+
+#endif  // ALLOCATION_COUNTER_HPP_
@@ -0,0 +1,167 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Times the two joy input paths on the same payloads: deserializing into
+// sensor_msgs/msg/Joy and copying into a snapshot, as joyCallback does, against
+// reading the bound entries straight from the CDR buffer, as
+// serializedJoyCallback does. Heap allocations are counted per message.
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "allocation_counter.hpp"
+#include "pb_teleop_twist_joy/joy_cdr_decoder.hpp"
+#include "pb_teleop_twist_joy/joy_snapshot.hpp"
+#include "rclcpp/serialization.hpp"
+#include "rclcpp/serialized_message.hpp"
+#include "rclcpp/time.hpp"
+#include "sensor_msgs/msg/joy.hpp"
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+// Messages per timed batch, small enough to see outliers, large enough that
+// the clock reads do not count.
+constexpr int BATCH_SIZE = 1000;
+
+struct PathResult
+{
+  double median_ns = 0.0;
+  double p99_ns = 0.0;
+  double allocations = 0.0;
+  // Sum over the bound entries, so the work cannot be optimized away and both
+  // paths can be checked to read the same values.
+  double checksum = 0.0;
+};
+
+template <typename Decode>
+PathResult timePath(int batches, Decode decode)
+{
+  std::vector<double> batch_ns(batches);
+  PathResult result;
+  uint64_t allocations_before = allocationCount();
+  for (int batch = 0; batch < batches; ++batch) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BATCH_SIZE; ++i) {
+      result.checksum += decode();
+    }
+    batch_ns[batch] =
+      std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+      BATCH_SIZE;
+  }
+  uint64_t allocations_after = allocationCount();
+  result.allocations = static_cast<double>(allocations_after - allocations_before) /
+                       (static_cast<double>(batches) * BATCH_SIZE);
+  std::sort(batch_ns.begin(), batch_ns.end());
+  result.median_ns = batch_ns[batch_ns.size() / 2];
+  result.p99_ns = batch_ns[std::min(batch_ns.size() - 1, batch_ns.size() * 99 / 100)];
+  return result;
+}
+
+void runPayload(const char * name, size_t num_axes, size_t num_buttons, int batches)
+{
+  // The bindings of the xbox config: four stick axes, enable and turbo.
+  const std::vector<int64_t> bound_axes = {0, 1, 3, 4};
+  const std::vector<int64_t> bound_buttons = {4, 5};
+
+  sensor_msgs::msg::Joy joy_msg;
+  joy_msg.header.stamp.sec = 1700000000;
+  joy_msg.header.frame_id = "joy";
+  joy_msg.axes.resize(num_axes);
+  joy_msg.buttons.resize(num_buttons);
+  for (size_t i = 0; i < num_axes; ++i) {
+    joy_msg.axes[i] = 0.01f * static_cast<float>(i + 1);
+  }
+  for (size_t i = 0; i < num_buttons; ++i) {
+    joy_msg.buttons[i] = static_cast<int32_t>(i % 2);
+  }
+  rclcpp::Serialization<sensor_msgs::msg::Joy> serialization;
+  rclcpp::SerializedMessage serialized_msg;
+  serialization.serialize_message(&joy_msg, &serialized_msg);
+  const rcl_serialized_message_t & buffer = serialized_msg.get_rcl_serialized_message();
+
+  auto sumBound = [&](const JoySnapshot & joy) {
+    double sum = 0.0;
+    for (int64_t axis : bound_axes) {
+      sum += joy.axis(axis);
+    }
+    for (int64_t button : bound_buttons) {
+      sum += joy.button(button) ? 1.0 : 0.0;
+    }
+    return sum;
+  };
+
+  // A fresh message per input, as the subscription hands out.
+  PathResult deserializing = timePath(batches, [&]() {
+    auto msg = std::make_shared<sensor_msgs::msg::Joy>();
+    serialization.deserialize_message(&serialized_msg, msg.get());
+    JoySnapshot joy;
+    joy.stamp_ns = rclcpp::Time(msg->header.stamp).nanoseconds();
+    joy.num_axes = static_cast<uint32_t>(msg->axes.size());
+    joy.num_buttons = static_cast<uint32_t>(msg->buttons.size());
+    std::copy_n(msg->axes.begin(), std::min(msg->axes.size(), JOY_MAX_AXES), joy.axes);
+    std::copy_n(
+      msg->buttons.begin(), std::min(msg->buttons.size(), JOY_MAX_BUTTONS), joy.buttons);
+    return sumBound(joy);
+  });
+
+  JoyCdrDecoder decoder;
+  decoder.bind(bound_axes, bound_buttons);
+  JoySnapshot serialized_joy;
+  PathResult partial = timePath(batches, [&]() {
+    if (!decoder.decode(buffer.buffer, buffer.buffer_length, &serialized_joy)) {
+      std::fprintf(stderr, "Decoding the %s payload failed.\n", name);
+      std::exit(1);
+    }
+    return sumBound(serialized_joy);
+  });
+
+  std::printf(
+    "%-8s %3zu axes %3zu buttons %5zu bytes\n", name, num_axes, num_buttons,
+    buffer.buffer_length);
+  const PathResult * results[2] = {&deserializing, &partial};
+  const char * path_names[2] = {"deserialize", "serialized"};
+  for (size_t i = 0; i < 2; ++i) {
+    std::printf(
+      "  %-12s median %8.1f ns  p99 %8.1f ns  %5.2f allocations/message\n", path_names[i],
+      results[i]->median_ns, results[i]->p99_ns, results[i]->allocations);
+  }
+  std::printf("  speedup %.1fx\n", deserializing.median_ns / partial.median_ns);
+  if (deserializing.checksum != partial.checksum) {
+    std::fprintf(stderr, "The paths read different values on the %s payload.\n", name);
+    std::exit(1);
+  }
+}
+}  // namespace
+
+}  // namespace pb_teleop_twist_joy
+
+int main(int argc, char ** argv)
+{
+  int64_t messages = argc > 1 ? std::strtoll(argv[1], nullptr, 10) : 1000000;
+  int batches = static_cast<int>(std::max<int64_t>(messages / 1000, 1));
+  // A typical gamepad, then a full-size message, where deserializing costs more
+  // and the partial decode the same.
+  pb_teleop_twist_joy::runPayload("gamepad", 8, 11, batches);
+  pb_teleop_twist_joy::runPayload("full", 32, 32, batches);
+  return 0;
+}
@@ -0,0 +1,355 @@
+// Copyright 2025 Lihan Chen
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Stress harness for the worst case execution and response time of the joy
+// processing. Runs the node in-process, drives it with joy messages at a fixed
+// rate while co-runner threads and a noise node load the machine, and reports
+// the largest times the node recorded over the whole run.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "diagnostic_msgs/msg/diagnostic_array.hpp"
+#include "nav2_msgs/action/navigate_to_pose.hpp"
+#include "pb_teleop_twist_joy/pb_teleop_twist_joy.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp_action/rclcpp_action.hpp"
+#include "sensor_msgs/msg/joy.hpp"
+#include "tf2_ros/transform_broadcaster.h"
+
+namespace pb_teleop_twist_joy
+{
+
+namespace
+{
+// Larger than the last level cache of the targets we run on.
+constexpr size_t CO_RUNNER_BUFFER_BYTES = 64 * 1024 * 1024;
+
+// Random read-modify-writes over a buffer, evicting the node's working set.
+void thrashCache(const std::atomic<bool> * stop)
+{
+  std::vector<uint64_t> buffer(CO_RUNNER_BUFFER_BYTES / sizeof(uint64_t), 1);
+  uint64_t state = 0x9e3779b97f4a7c15ULL;
+  while (!stop->load(std::memory_order_relaxed)) {
+    for (int i = 0; i < 4096; ++i) {
+      state ^= state << 13;
+      state ^= state >> 7;
+      state ^= state << 17;
+      buffer[state % buffer.size()] += state;
+    }
+  }
+}
+
+// Streaming copies, saturating memory bandwidth.
+void hogBandwidth(const std::atomic<bool> * stop)
+{
+  std::vector<char> source(CO_RUNNER_BUFFER_BYTES, 1);
+  std::vector<char> destination(CO_RUNNER_BUFFER_BYTES, 0);
+  while (!stop->load(std::memory_order_relaxed)) {
+    std::memcpy(destination.data(), source.data(), source.size());
+    source.swap(destination);
+  }
+}
+
+struct WorstCase
+{
+  double max_us = 0.0;
+  double worst_p99_us = 0.0;
+  uint64_t count = 0;
+};
+
+double valueOf(const diagnostic_msgs::msg::DiagnosticStatus & status, const char * key)
+{
+  for (const auto & value : status.values) {
+    if (value.key == key) {
+      return std::stod(value.value);
+    }
+  }
+  return 0.0;
+}
+}  // namespace
+
+// Interference the node does not cause itself: TF bursts, parameter service
+// calls and a navigation action server that answers late. Spun on its own
+// executor, so a slow action server delays only the node's goal responses.
+class NoiseNode : public rclcpp::Node
+{
+public:
+  using NavigateToPose = nav2_msgs::action::NavigateToPose;
+
+  NoiseNode(const std::string & target_node, const std::string & robot_base_frame)
+  : Node("wcet_stress_noise"), robot_base_frame_(robot_base_frame)
+  {
+    tf_burst_size_ = std::max<int64_t>(this->declare_parameter<int64_t>("tf_burst_size", 500), 0);
+    double tf_burst_period = this->declare_parameter<double>("tf_burst_period", 0.1);
+    double parameter_update_period =
+      this->declare_parameter<double>("parameter_update_period", 0.05);
+    action_delay_ = this->declare_parameter<double>("action_delay", 0.05);
+
+    tf_broadcaster_ = std::make_unique<tf2_ros::TransformBroadcaster>(*this);
+    if (tf_burst_period > 0.0) {
+      tf_timer_ = this->create_wall_timer(
+        std::chrono::duration<double>(tf_burst_period), [this]() { sendTfBurst(); });
+    }
+    parameters_client_ = std::make_shared<rclcpp::AsyncParametersClient>(this, target_node);
+    if (parameter_update_period > 0.0) {
+      parameter_timer_ = this->create_wall_timer(
+        std::chrono::duration<double>(parameter_update_period), [this]() {
+          if (parameters_client_->service_is_ready()) {
+            parameters_client_->set_parameters({rclcpp::Parameter("hot_path_log_period", 1.0)});
+          }
+        });
+    }
+    action_server_ = rclcpp_action::create_server<NavigateToPose>(
+      this, "navigate_to_pose",
+      [this](const rclcpp_action::GoalUUID &, std::shared_ptr<const NavigateToPose::Goal>) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(action_delay_));
+        return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+      },
+      [](const std::shared_ptr<rclcpp_action::ServerGoalHandle<NavigateToPose>>) {
+        return rclcpp_action::CancelResponse::ACCEPT;
+      },
+      [](const std::shared_ptr<rclcpp_action::ServerGoalHandle<NavigateToPose>> goal_handle) {
+        goal_handle->succeed(std::make_shared<NavigateToPose::Result>());
+      });
+  }
+
+private:
+  void sendTfBurst()
+  {
+    std::vector<geometry_msgs::msg::TransformStamped> transforms(tf_burst_size_ + 1);
+    rclcpp::Time now = this->now();
+    for (size_t i = 0; i < transforms.size(); ++i) {
+      transforms[i].header.stamp = now;
+      transforms[i].header.frame_id = "map";
+      transforms[i].child_frame_id = "wcet_noise_" + std::to_string(i);
+      transforms[i].transform.rotation.w = 1.0;
+    }
+    // The frame goals are transformed from, so auto_control finds it.
+    transforms.back().child_frame_id = robot_base_frame_;
+    tf_broadcaster_->sendTransform(transforms);
+  }
+
+  std::string robot_base_frame_;
+  int64_t tf_burst_size_;
+  double action_delay_;
+  std::unique_ptr<tf2_ros::TransformBroadcaster> tf_broadcaster_;
+  rclcpp::TimerBase::SharedPtr tf_timer_;
+  std::shared_ptr<rclcpp::AsyncParametersClient> parameters_client_;
+  rclcpp::TimerBase::SharedPtr parameter_timer_;
+  rclcpp_action::Server<NavigateToPose>::SharedPtr action_server_;
+};
+
+// Publishes joy at a fixed rate and collects the node's duration statistics.
+// Each statistics window reports its exact maximum, the harness keeps the
+// largest over all windows.
+class WcetStressNode : public rclcpp::Node
+{
+public:
+  WcetStressNode(const std::string & target_node, int64_t enable_button)
+  : Node("wcet_stress"), target_node_(target_node), enable_button_(enable_button), published_(0)
+  {
+    iterations_ = this->declare_parameter<int64_t>("iterations", 1000000);
+    rate_ = this->declare_parameter<double>("rate", 1000.0);
+    budget_margin_ = this->declare_parameter<double>("budget_margin", 0.2);
+    report_path_ = this->declare_parameter<std::string>("report_path", "wcet_report.txt");
+    cache_thrashers_ = this->declare_parameter<int64_t>("cache_thrashers", 1);
+    bandwidth_hogs_ = this->declare_parameter<int64_t>("bandwidth_hogs", 1);
+
+    joy_pub_ = this->create_publisher<sensor_msgs::msg::Joy>("joy", 10);
+    diagnostics_sub_ = this->create_subscription<diagnostic_msgs::msg::DiagnosticArray>(
+      "diagnostics", 10,
+      std::bind(&WcetStressNode::diagnosticsCallback, this, std::placeholders::_1));
+  }
+
+  int64_t cacheThrashers() const { return cache_thrashers_; }
+  int64_t bandwidthHogs() const { return bandwidth_hogs_; }
+
+  // Publishes all iterations, sweeping the sticks so every branch is taken.
+  void run()
+  {
+    sensor_msgs::msg::Joy joy_msg;
+    joy_msg.axes.resize(8);
+    joy_msg.buttons.resize(12);
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(1.0 / rate_));
+    auto next = std::chrono::steady_clock::now();
+    for (int64_t i = 0; i < iterations_ && rclcpp::ok(); ++i) {
+      float phase = static_cast<float>(i % 2000) / 1000.0f - 1.0f;
+      for (size_t axis = 0; axis < joy_msg.axes.size(); ++axis) {
+        joy_msg.axes[axis] = (axis % 2 == 0) ? phase : -phase;
+      }
+      // Released every 500th input, so the stop path is measured too.
+      int32_t enabled = (i % 500) != 499 ? 1 : 0;
+      if (enable_button_ >= 0 && enable_button_ < static_cast<int64_t>(joy_msg.buttons.size())) {
+        joy_msg.buttons[enable_button_] = enabled;
+      }
+      joy_msg.header.stamp = this->now();
+      joy_pub_->publish(joy_msg);
+      ++published_;
+      next += period;
+      std::this_thread::sleep_until(next);
+    }
+  }
+
+  std::string report(const std::string & control_mode, const std::string & noise) const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::ostringstream out;
+    char line[256];
+    out << "pb_teleop_twist_joy WCET stress report\n";
+    std::snprintf(
+      line, sizeof(line), "inputs: %" PRId64 " published, %" PRIu64 " processed at %.0f Hz\n",
+      published_.load(), execution_.count, rate_);
+    out << line;
+    out << "control_mode: " << control_mode << "\n";
+    std::snprintf(
+      line, sizeof(line), "co-runners: %" PRId64 " cache thrashers, %" PRId64 " bandwidth hogs\n",
+      cache_thrashers_, bandwidth_hogs_);
+    out << line << "noise: " << noise << "\n";
+    const WorstCase * cases[2] = {&execution_, &response_};
+    const char * names[2] = {"execution (joy processing)", "response (joy stamp to command)"};
+    for (size_t i = 0; i < 2; ++i) {
+      std::snprintf(
+        line, sizeof(line), "%s: max %.1f us, worst window p99 %.1f us, budget %.1f us\n",
+        names[i], cases[i]->max_us, cases[i]->worst_p99_us,
+        cases[i]->max_us * (1.0 + budget_margin_));
+      out << line;
+    }
+    out << "Observed maxima, not a proven bound. Budgets add " << budget_margin_ * 100.0
+        << " % margin.\n";
+    return out.str();
+  }
+
+  const std::string & reportPath() const { return report_path_; }
+
+private:
+  void diagnosticsCallback(const diagnostic_msgs::msg::DiagnosticArray::SharedPtr msg)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto & status : msg->status) {
+      WorstCase * worst = nullptr;
+      if (status.name == target_node_ + ": joy processing") {
+        worst = &execution_;
+      } else if (status.name == target_node_ + ": joy stamp to command latency") {
+        worst = &response_;
+      } else {
+        continue;
+      }
+      worst->count += static_cast<uint64_t>(valueOf(status, "count"));
+      worst->max_us = std::max(worst->max_us, valueOf(status, "max_us"));
+      worst->worst_p99_us = std::max(worst->worst_p99_us, valueOf(status, "p99_us"));
+    }
+  }
+
+  std::string target_node_;
+  int64_t enable_button_;
+  int64_t iterations_;
+  double rate_;
+  double budget_margin_;
+  std::string report_path_;
+  int64_t cache_thrashers_;
+  int64_t bandwidth_hogs_;
+  std::atomic<int64_t> published_;
+
+  rclcpp::Publisher<sensor_msgs::msg::Joy>::SharedPtr joy_pub_;
+  rclcpp::Subscription<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_sub_;
+  mutable std::mutex mutex_;
+  WorstCase execution_;
+  WorstCase response_;
+};
+
+}  // namespace pb_teleop_twist_joy
+
+int main(int argc, char ** argv)
+{
+  using pb_teleop_twist_joy::NoiseNode;
+  using pb_teleop_twist_joy::TeleopTwistJoyNode;
+  using pb_teleop_twist_joy::WcetStressNode;
+  rclcpp::init(argc, argv);
+
+  // Named as in the launch files, so their parameter files apply. Statistics
+  // are what is measured, the rest comes from --ros-args.
+  rclcpp::NodeOptions teleop_options;
+  teleop_options.arguments({"--ros-args", "-r", "__node:=pb_teleop_twist_joy"});
+  teleop_options.append_parameter_override("statistics.enable", true);
+  teleop_options.append_parameter_override("statistics.period", 1.0);
+  auto teleop_node = std::make_shared<TeleopTwistJoyNode>(teleop_options);
+  auto stress_node = std::make_shared<WcetStressNode>(
+    teleop_node->get_name(), teleop_node->get_parameter("enable_button").as_int());
+  auto noise_node = std::make_shared<NoiseNode>(
+    teleop_node->get_fully_qualified_name(),
+    teleop_node->get_parameter("robot_base_frame").as_string());
+
+  // The node under test gets its own executor thread, as in a real process.
+  rclcpp::executors::SingleThreadedExecutor teleop_executor;
+  rclcpp::executors::SingleThreadedExecutor stress_executor;
+  rclcpp::executors::SingleThreadedExecutor noise_executor;
+  teleop_executor.add_node(teleop_node);
+  stress_executor.add_node(stress_node);
+  noise_executor.add_node(noise_node);
+  std::thread teleop_thread([&]() { teleop_executor.spin(); });
+  std::thread stress_thread([&]() { stress_executor.spin(); });
+  std::thread noise_thread([&]() { noise_executor.spin(); });
+
+  std::atomic<bool> stop(false);
+  std::vector<std::thread> co_runners;
+  for (int64_t i = 0; i < stress_node->cacheThrashers(); ++i) {
+    co_runners.emplace_back(pb_teleop_twist_joy::thrashCache, &stop);
+  }
+  for (int64_t i = 0; i < stress_node->bandwidthHogs(); ++i) {
+    co_runners.emplace_back(pb_teleop_twist_joy::hogBandwidth, &stop);
+  }
+
+  stress_node->run();
+  // Let the last statistics window arrive.
+  std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+
+  stop = true;
+  for (auto & co_runner : co_runners) {
+    co_runner.join();
+  }
+  std::ostringstream noise;
+  noise << "tf burst " << noise_node->get_parameter("tf_burst_size").as_int() << " every "
+        << noise_node->get_parameter("tf_burst_period").as_double() << " s, parameter update every "
+        << noise_node->get_parameter("parameter_update_period").as_double()
+        << " s, action delay " << noise_node->get_parameter("action_delay").as_double() << " s";
+  std::string report = stress_node->report(
+    teleop_node->get_parameter("control_mode").as_string(), noise.str());
+  std::fputs(report.c_str(), stdout);
+  std::ofstream report_file(stress_node->reportPath());
+  report_file << report;
+
+  teleop_executor.cancel();
+  stress_executor.cancel();
+  noise_executor.cancel();
+  teleop_thread.join();
+  stress_thread.join();
+  noise_thread.join();
+  rclcpp::shutdown();
+  return 0;
+}